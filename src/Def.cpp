@@ -19,10 +19,30 @@
  * Categories:
  * - Arithmetic: +, -, *, /, modulo, expt
  * - Comparison: <, <=, =, >=, >
- * - List operations: cons, car, cdr, list, set-car!, set-cdr!
+ * - List operations: cons, car, cdr, list, set-car!, set-cdr!, append
+ * - String operations: string-append, substring, string-length, string-ref,
+ *   string->symbol, symbol->string, number->string, string->list, list->string
+ * - Vectors: make-vector, vector, vector?, vector-length, vector-ref, vector-set!,
+ *   vector->list, list->vector, vector-sum, vector-dot, vector-max, vector+, vector-map
+ * - Hashtables: make-eq-hashtable, make-weak-eq-hashtable, hashtable?, hashtable-size,
+ *   hashtable-ref, hashtable-set!, hashtable-contains?, hashtable-delete!,
+ *   hashtable-keys, hashtable-clear!
+ * - Characters: char?, char->integer, integer->char, char=?, char<?
+ * - Bytevectors: make-bytevector, bytevector, bytevector?, bytevector-length,
+ *   bytevector-u8-ref, bytevector-u8-set!, bytevector-copy!, bytevector-fill!
  * - Logic: not, and, or (and/or support short-circuit evaluation)
  * - Type predicates: eq?, boolean?, number?, null?, pair?, procedure?, symbol?, list?, string?
- * - I/O: display
+ * - Promises: make-promise, force, promise?
+ * - Continuations: call/cc, call-with-current-continuation, dynamic-wind
+ * - Exceptions: raise, raise-continuable, with-exception-handler, error,
+ *   error-object?, error-object-message, error-object-irritants
+ * - Multiple values: values, call-with-values
+ * - Parallelism: future, touch, pmap, parallel-for
+ * - Procedures: apply
+ * - I/O: display, write, write-string, write-char, newline,
+ *   open-output-string, get-output-string, current-output-port,
+ *   read-line, read-char, peek-char, read, stdin-lines, eof-object, eof-object?
+ * - Memory: gc, gc-stats, heap-stats, heap-limit!, dump-heap
  * - Control: void, exit
  */
 std::map<std::string, ExprType> primitives = {
@@ -48,6 +68,62 @@ std::map<std::string, ExprType> primitives = {
     {"list",      E_LIST},
     {"set-car!",  E_SETCAR},
     {"set-cdr!",  E_SETCDR},
+    {"append",    E_APPEND},
+
+    // String operations
+    {"string-append",  E_STRING_APPEND},
+    {"substring",      E_SUBSTRING},
+    {"string-length",  E_STRING_LENGTH},
+    {"string-ref",     E_STRING_REF},
+    {"string->symbol", E_STRING_TO_SYMBOL},
+    {"symbol->string", E_SYMBOL_TO_STRING},
+    {"number->string", E_NUMBER_TO_STRING},
+    {"string->list",   E_STRING_TO_LIST},
+    {"list->string",   E_LIST_TO_STRING},
+
+    // Bytevectors
+    {"make-bytevector",    E_MAKE_BYTEVECTOR},
+    {"bytevector",         E_BYTEVECTOR},
+    {"bytevector?",        E_BYTEVECTORQ},
+    {"bytevector-length",  E_BYTEVECTOR_LENGTH},
+    {"bytevector-u8-ref",  E_BYTEVECTOR_REF},
+    {"bytevector-u8-set!", E_BYTEVECTOR_SET},
+    {"bytevector-copy!",   E_BYTEVECTOR_COPY},
+    {"bytevector-fill!",   E_BYTEVECTOR_FILL},
+
+    // Vectors
+    {"make-vector",    E_MAKE_VECTOR},
+    {"vector",         E_VECTOR},
+    {"vector?",        E_VECTORQ},
+    {"vector-length",  E_VECTOR_LENGTH},
+    {"vector-ref",     E_VECTOR_REF},
+    {"vector-set!",    E_VECTOR_SET},
+    {"vector->list",   E_VECTOR_TO_LIST},
+    {"list->vector",   E_LIST_TO_VECTOR},
+    {"vector-sum",     E_VECTOR_SUM},
+    {"vector-dot",     E_VECTOR_DOT},
+    {"vector-max",     E_VECTOR_MAX},
+    {"vector+",        E_VECTOR_ADD},
+    {"vector-map",     E_VECTOR_MAP},
+
+    // Hashtables
+    {"make-eq-hashtable",      E_MAKE_EQ_HASHTABLE},
+    {"make-weak-eq-hashtable", E_MAKE_WEAK_EQ_HASHTABLE},
+    {"hashtable?",             E_HASHTABLEQ},
+    {"hashtable-size",         E_HASHTABLE_SIZE},
+    {"hashtable-ref",          E_HASHTABLE_REF},
+    {"hashtable-set!",         E_HASHTABLE_SET},
+    {"hashtable-contains?",    E_HASHTABLE_CONTAINS},
+    {"hashtable-delete!",      E_HASHTABLE_DELETE},
+    {"hashtable-keys",         E_HASHTABLE_KEYS},
+    {"hashtable-clear!",       E_HASHTABLE_CLEAR},
+
+    // Characters
+    {"char?",          E_CHARQ},
+    {"char->integer",  E_CHAR_TO_INTEGER},
+    {"integer->char",  E_INTEGER_TO_CHAR},
+    {"char=?",         E_CHAR_EQ},
+    {"char<?",         E_CHAR_LT},
 
     // Logic operations
     {"not",       E_NOT},
@@ -65,8 +141,61 @@ std::map<std::string, ExprType> primitives = {
     {"list?",      E_LISTQ},
     {"string?",    E_STRINGQ},
     
+    // Promises
+    {"make-promise", E_MAKE_PROMISE},
+    {"force",        E_FORCE},
+    {"promise?",     E_PROMISEQ},
+
+    // Continuations
+    {"call/cc",                        E_CALLCC},
+    {"call-with-current-continuation", E_CALLCC},
+    {"dynamic-wind",                   E_DYNAMIC_WIND},
+
+    // Exceptions
+    {"raise",                  E_RAISE},
+    {"raise-continuable",      E_RAISE_CONTINUABLE},
+    {"with-exception-handler", E_WITH_HANDLER},
+    {"error",                  E_ERROR},
+    {"error-object?",          E_ERRORQ},
+    {"error-object-message",   E_ERROR_MESSAGE},
+    {"error-object-irritants", E_ERROR_IRRITANTS},
+
+    // Parallelism
+    {"future",           E_FUTURE},
+    {"touch",            E_TOUCH},
+    {"pmap",             E_PMAP},
+    {"parallel-for",     E_PARALLEL_FOR},
+
+    // Multiple values
+    {"values",           E_VALUES},
+    {"call-with-values", E_CALL_WITH_VALUES},
+
+    // Procedures
+    {"apply",            E_APPLY_PROC},
+
     // I/O operations
-    {"display",   E_DISPLAY},
+    {"display",             E_DISPLAY},
+    {"write",               E_WRITE},
+    {"write-string",        E_WRITE_STRING},
+    {"write-char",          E_WRITE_CHAR},
+    {"newline",             E_NEWLINE},
+    {"open-output-string",  E_OPEN_OUTPUT_STRING},
+    {"get-output-string",   E_GET_OUTPUT_STRING},
+    {"current-output-port", E_CURRENT_OUTPUT_PORT},
+    {"read-line",           E_READ_LINE},
+    {"read-char",           E_READ_CHAR},
+    {"peek-char",           E_PEEK_CHAR},
+    {"read",                E_READ},
+    {"stdin-lines",         E_STDIN_LINES},
+    {"eof-object",          E_EOF_OBJECT},
+    {"eof-object?",         E_EOF_OBJECTQ},
+
+    // Memory
+    {"gc",        E_GC},
+    {"gc-stats",  E_GC_STATS},
+    {"heap-stats", E_HEAP_STATS},
+    {"heap-limit!", E_HEAP_LIMIT},
+    {"dump-heap", E_DUMP_HEAP},
     
     // Special values and control
     {"void",      E_VOID},
@@ -81,12 +210,18 @@ std::map<std::string, ExprType> primitives = {
  * have special parsing and evaluation semantics.
  * 
  * Categories:
- * - Control flow constructs: begin, quote
- * - Conditional : if, cond
+ * - Control flow constructs: begin, quote, quasiquote
+ * - Conditional : if, cond, case
  * - Function definition: lambda
  * - Variable and function definition: define
  * - Binding constructs: let, letrec
  * - Assignment: set!
+ * - Macros: define-syntax
+ * - Records: define-record-type
+ * - Promises: delay, delay-force
+ * - Exceptions: guard
+ * - Multiple values: let-values, receive
+ * - Procedures: case-lambda
  * 
  * Note: and/or have been moved to primitives to support function-style usage
  * while maintaining their short-circuit evaluation behavior.
@@ -95,10 +230,12 @@ std::map<std::string, ExprType> reserved_words = {
     // Control flow constructs
     {"begin",   E_BEGIN},    
     {"quote",   E_QUOTE},    
+    {"quasiquote", E_QUASIQUOTE},
 
     // Conditional
     {"if",      E_IF},       
     {"cond",    E_COND},     
+    {"case",    E_CASE},
 
     // Function definition
     {"lambda",  E_LAMBDA},   
@@ -111,5 +248,25 @@ std::map<std::string, ExprType> reserved_words = {
     {"letrec",  E_LETREC},   
     
     // Assignment
-    {"set!",    E_SET}      
+    {"set!",    E_SET},
+
+    // Macros
+    {"define-syntax", E_DEFINE_SYNTAX},
+
+    // Records
+    {"define-record-type", E_DEFINE_RECORD},
+
+    // Promises
+    {"delay",       E_DELAY},
+    {"delay-force", E_DELAY_FORCE},
+
+    // Exceptions
+    {"guard",       E_GUARD},
+
+    // Multiple values
+    {"let-values",  E_LET_VALUES},
+    {"receive",     E_LET_VALUES},
+
+    // Procedures
+    {"case-lambda", E_CASE_LAMBDA}
 };
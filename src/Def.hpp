@@ -20,8 +20,12 @@
 struct Syntax;
 struct Expr;
 struct Value;
+struct ValueBase;
 struct AssocList;
 struct Assoc;
+struct RecordType;
+struct ContinuationState;
+struct Task;
 
 /**
  * @brief Expression types enumeration
@@ -61,6 +65,62 @@ enum ExprType {
     E_LIST,             
     E_SETCAR,          
     E_SETCDR,          
+    E_APPEND,
+
+    // String operations
+    E_STRING_APPEND,
+    E_SUBSTRING,
+    E_STRING_LENGTH,
+    E_STRING_REF,
+    E_STRING_TO_SYMBOL,
+    E_SYMBOL_TO_STRING,
+    E_NUMBER_TO_STRING,
+    E_STRING_TO_LIST,
+    E_LIST_TO_STRING,
+
+    // Bytevectors
+    E_MAKE_BYTEVECTOR,
+    E_BYTEVECTOR,
+    E_BYTEVECTORQ,
+    E_BYTEVECTOR_LENGTH,
+    E_BYTEVECTOR_REF,
+    E_BYTEVECTOR_SET,
+    E_BYTEVECTOR_COPY,
+    E_BYTEVECTOR_FILL,
+
+    // Vectors
+    E_MAKE_VECTOR,
+    E_VECTOR,
+    E_VECTORQ,
+    E_VECTOR_LENGTH,
+    E_VECTOR_REF,
+    E_VECTOR_SET,
+    E_VECTOR_TO_LIST,
+    E_LIST_TO_VECTOR,
+    E_VECTOR_SUM,
+    E_VECTOR_DOT,
+    E_VECTOR_MAX,
+    E_VECTOR_ADD,
+    E_VECTOR_MAP,
+
+    // Hashtables
+    E_MAKE_EQ_HASHTABLE,
+    E_MAKE_WEAK_EQ_HASHTABLE,
+    E_HASHTABLEQ,
+    E_HASHTABLE_SIZE,
+    E_HASHTABLE_REF,
+    E_HASHTABLE_SET,
+    E_HASHTABLE_CONTAINS,
+    E_HASHTABLE_DELETE,
+    E_HASHTABLE_KEYS,
+    E_HASHTABLE_CLEAR,
+
+    // Characters
+    E_CHARQ,
+    E_CHAR_TO_INTEGER,
+    E_INTEGER_TO_CHAR,
+    E_CHAR_EQ,
+    E_CHAR_LT,
 
     // Logic operations
     E_NOT,              
@@ -81,26 +141,97 @@ enum ExprType {
     // Control flow constructs
     E_BEGIN,          
     E_QUOTE,          
+    E_QUASIQUOTE,
 
     //Conditional
     E_IF,             
     E_COND,            
+    E_CASE,
 
     // Variables and function definition
     E_VAR,              
     E_APPLY,           
     E_LAMBDA,         
+    E_CASE_LAMBDA,
     E_DEFINE,          
+    E_APPLY_PROC,
+    E_PRIMITIVE_CALL,
 
     // Binding constructs
     E_LET,            
     E_LETREC,          
+    E_SCOPE,
 
     // Assignment
     E_SET,             
 
+    // Macros
+    E_DEFINE_SYNTAX,
+
+    // Records
+    E_DEFINE_RECORD,
+    E_RECORD_MAKE,
+    E_RECORD_IS,
+    E_RECORD_REF,
+    E_RECORD_SET,
+
+    // Promises
+    E_DELAY,
+    E_DELAY_FORCE,
+    E_MAKE_PROMISE,
+    E_FORCE,
+    E_PROMISEQ,
+
+    // Continuations
+    E_CALLCC,
+    E_DYNAMIC_WIND,
+    E_CONTINUE,
+
+    // Exceptions
+    E_RAISE,
+    E_RAISE_CONTINUABLE,
+    E_WITH_HANDLER,
+    E_GUARD,
+    E_ERROR,
+    E_ERRORQ,
+    E_ERROR_MESSAGE,
+    E_ERROR_IRRITANTS,
+
+    // Parallelism
+    E_FUTURE,
+    E_TOUCH,
+    E_PMAP,
+    E_PARALLEL_FOR,
+
+    // Multiple values
+    E_VALUES,
+    E_CALL_WITH_VALUES,
+    E_LET_VALUES,
+
     // I/O operations
     E_DISPLAY,         
+    E_WRITE,
+    E_WRITE_STRING,
+    E_WRITE_CHAR,
+    E_NEWLINE,
+    E_OPEN_OUTPUT_STRING,
+    E_GET_OUTPUT_STRING,
+    E_CURRENT_OUTPUT_PORT,
+    E_READ_LINE,
+    E_READ_CHAR,
+    E_PEEK_CHAR,
+    E_READ,
+    E_STDIN_LINES,
+    E_NEXT_LINE,
+    E_EOF_OBJECT,
+    E_EOF_OBJECTQ,
+
+    // Memory
+    E_GC,
+    E_GC_STATS,
+    E_HEAP_STATS,
+    E_HEAP_LIMIT,
+    E_DUMP_HEAP,
 };
 
 /**
@@ -118,6 +249,18 @@ enum ValueType {
     V_STRING,           
     V_PAIR,             
     V_PROC,             
+    V_RECORD,
+    V_PROMISE,
+    V_ERROR,
+    V_VALUES,
+    V_PORT,
+    V_EOF,
+    V_CHAR,
+    V_BYTEVECTOR,
+    V_VECTOR,
+    V_FUTURE,
+    V_FRAME,
+    V_HASHTABLE,
     V_VOID,            
     V_TERMINATE        
 };
@@ -1,5 +1,7 @@
 #include "RE.hpp"
 #include <cstring>
 
-RuntimeError::RuntimeError(std::string s1) : s(s1) {}
-std::string RuntimeError::message() const { return s; }
\ No newline at end of file
+RuntimeError::RuntimeError(const char *p) : prefix(p) {}
+RuntimeError::RuntimeError(const char *p, const std::string &detail) : prefix(p), s(detail) {}
+RuntimeError::RuntimeError(std::string s1) : prefix(nullptr), s(s1) {}
+std::string RuntimeError::message() const { return prefix == nullptr ? s : prefix + s; }
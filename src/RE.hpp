@@ -4,12 +4,21 @@
 #include <exception>
 #include <string>
 
+/**
+ * Error messages are assembled only when message() is asked for, so code
+ * that raises and handles errors in a loop never builds strings. A literal
+ * message costs nothing; a detail (such as a variable name) is kept apart
+ * from the literal until then.
+ */
 class RuntimeError : std::exception {
     private:
+        const char *prefix;
         std::string s;
     public:
+        RuntimeError(const char *);
+        RuntimeError(const char *, const std::string &);
         RuntimeError(std::string);
         std::string message() const;
 };
 
-#endif
\ No newline at end of file
+#endif
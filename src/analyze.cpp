@@ -0,0 +1,263 @@
+/**
+ * @file analyze.cpp
+ * @brief heap-analyze: who holds the memory in a heap dump
+ *
+ * Reads a dump written by dump-heap (format in dump.hpp) and builds the
+ * dominator tree of its reference graph, rooted at a virtual node that
+ * references every value with external references. A value's retained size
+ * is the total size of the values it dominates: what freeing it would free.
+ * Reports totals per type, then the values retaining the most among
+ * procedures (closures), top-level bindings and environment chains (frames
+ * not dominated by another frame).
+ *
+ *   heap-analyze dump [top]
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Node {
+    std::string type;
+    std::string label;
+    size_t bytes = 0;
+    long external = 0;
+    std::vector<size_t> out;
+    std::vector<size_t> in;
+};
+
+struct Global {
+    size_t binding;
+    long value;
+    std::string name;
+};
+
+struct Heap {
+    std::vector<Node> nodes;     ///< Node 0 is the virtual root
+    std::vector<Global> globals;
+};
+
+bool load(const char *path, Heap &h) {
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line) || line.compare(0, 16, "scheme-heap-dump") != 0) {
+        std::cerr << path << ": not a heap dump\n";
+        return false;
+    }
+    h.nodes.resize(1);
+    h.nodes[0].type = "root";
+    while (std::getline(in, line)) {
+        std::istringstream ss(line);
+        char kind;
+        ss >> kind;
+        if (kind == 'n') {
+            size_t id;
+            Node n;
+            ss >> id >> n.type >> n.bytes >> n.external;
+            ss.get();
+            std::getline(ss, n.label);
+            if (id + 1 != h.nodes.size()) {
+                std::cerr << path << ": nodes out of order at " << id << "\n";
+                return false;
+            }
+            h.nodes.push_back(n);
+        } else if (kind == 'e') {
+            size_t from, to;
+            ss >> from >> to;
+            if (from + 1 >= h.nodes.size() || to + 1 >= h.nodes.size()) {
+                std::cerr << path << ": edge to an unknown value\n";
+                return false;
+            }
+            h.nodes[from + 1].out.push_back(to + 1);
+            h.nodes[to + 1].in.push_back(from + 1);
+        } else if (kind == 'g') {
+            Global g;
+            ss >> g.binding >> g.value;
+            ss.get();
+            std::getline(ss, g.name);
+            g.binding++;
+            if (g.value >= 0) {
+                g.value++;
+            }
+            h.globals.push_back(g);
+        }
+    }
+    for (size_t i = 1; i < h.nodes.size(); i++) {
+        if (h.nodes[i].external > 0) {
+            h.nodes[0].out.push_back(i);
+            h.nodes[i].in.push_back(0);
+        }
+    }
+    return true;
+}
+
+const size_t NONE = (size_t)-1;
+
+/**
+ * @brief Immediate dominators (Cooper, Harvey and Kennedy), NONE where unreachable
+ * Fills order with the reachable nodes in reverse postorder.
+ */
+std::vector<size_t> dominators(const Heap &h, std::vector<size_t> &order) {
+    size_t n = h.nodes.size();
+    std::vector<size_t> post(n, NONE);
+    std::vector<bool> seen(n, false);
+    std::vector<std::pair<size_t, size_t>> stack;
+    std::vector<size_t> postorder;
+    stack.emplace_back(0, 0);
+    seen[0] = true;
+    while (!stack.empty()) {
+        size_t v = stack.back().first;
+        size_t &next = stack.back().second;
+        if (next < h.nodes[v].out.size()) {
+            size_t w = h.nodes[v].out[next++];
+            if (!seen[w]) {
+                seen[w] = true;
+                stack.emplace_back(w, 0);
+            }
+        } else {
+            post[v] = postorder.size();
+            postorder.push_back(v);
+            stack.pop_back();
+        }
+    }
+    order.assign(postorder.rbegin(), postorder.rend());
+    std::vector<size_t> idom(n, NONE);
+    idom[0] = 0;
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (size_t k = 1; k < order.size(); k++) {
+            size_t v = order[k];
+            size_t d = NONE;
+            for (size_t p : h.nodes[v].in) {
+                if (idom[p] == NONE) {
+                    continue;
+                }
+                if (d == NONE) {
+                    d = p;
+                    continue;
+                }
+                size_t a = p, b = d;
+                while (a != b) {
+                    while (post[a] < post[b]) {
+                        a = idom[a];
+                    }
+                    while (post[b] < post[a]) {
+                        b = idom[b];
+                    }
+                }
+                d = a;
+            }
+            if (d != idom[v]) {
+                idom[v] = d;
+                changed = true;
+            }
+        }
+    }
+    return idom;
+}
+
+struct Row {
+    size_t retained;
+    std::string text;
+};
+
+void report(const char *title, std::vector<Row> &rows, size_t top) {
+    std::sort(rows.begin(), rows.end(), [](const Row &a, const Row &b) { return a.retained > b.retained; });
+    std::printf("\n%s (%zu)\n", title, rows.size());
+    for (size_t i = 0; i < rows.size() && i < top; i++) {
+        std::printf("  %12zu  %s\n", rows[i].retained, rows[i].text.c_str());
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        std::cerr << "usage: heap-analyze dump [top]\n";
+        return 2;
+    }
+    size_t top = argc > 2 ? (size_t)std::max(1, std::atoi(argv[2])) : 20;
+    Heap h;
+    if (!load(argv[1], h)) {
+        return 1;
+    }
+    std::vector<size_t> order;
+    std::vector<size_t> idom = dominators(h, order);
+    std::vector<size_t> retained(h.nodes.size(), 0);
+    for (size_t k = order.size(); k-- > 1;) {
+        size_t v = order[k];
+        retained[v] += h.nodes[v].bytes;
+        retained[idom[v]] += retained[v];
+    }
+
+    size_t total = 0, unreachable = 0;
+    std::map<std::string, std::pair<size_t, size_t>> by_type;
+    for (size_t v = 1; v < h.nodes.size(); v++) {
+        total += h.nodes[v].bytes;
+        if (idom[v] == NONE) {
+            unreachable += h.nodes[v].bytes;
+        }
+        by_type[h.nodes[v].type].first++;
+        by_type[h.nodes[v].type].second += h.nodes[v].bytes;
+    }
+    std::printf("values %zu  bytes %zu  unreachable %zu\n", h.nodes.size() - 1, total, unreachable);
+    std::printf("\nby type\n");
+    for (auto &t : by_type) {
+        std::printf("  %12zu  %-12s %zu\n", t.second.second, t.first.c_str(), t.second.first);
+    }
+
+    std::vector<Row> procedures, globals, chains;
+    for (size_t v = 1; v < h.nodes.size(); v++) {
+        const Node &n = h.nodes[v];
+        if (idom[v] == NONE) {
+            continue;
+        }
+        if (n.type == "procedure") {
+            procedures.push_back({retained[v], "#" + std::to_string(v - 1) + " " + n.label});
+        } else if (n.type == "frame" && h.nodes[idom[v]].type != "frame") {
+            size_t frames = 0;
+            std::string names;
+            // Walk the chain the frame heads while it owns the frames
+            for (size_t f = v; f != NONE;) {
+                frames++;
+                if (frames <= 4) {
+                    names += " " + h.nodes[f].label;
+                }
+                size_t next = NONE;
+                for (size_t w : h.nodes[f].out) {
+                    if (h.nodes[w].type == "frame" && idom[w] == f) {
+                        next = w;
+                    }
+                }
+                f = next;
+            }
+            chains.push_back({retained[v], "#" + std::to_string(v - 1) + " " + std::to_string(frames) +
+                                           " bindings:" + names + (frames > 4 ? " ..." : "")});
+        }
+    }
+    for (const Global &g : h.globals) {
+        size_t r = 0;
+        std::string note;
+        if (g.value < 0) {
+            note = " (immortal)";
+        } else if (idom[g.value] == g.binding) {
+            r = retained[g.value];
+        } else {
+            note = " (shared)";
+        }
+        globals.push_back({r, g.name + note});
+    }
+    report("procedures by retained bytes", procedures, top);
+    report("top-level bindings by retained bytes", globals, top);
+    report("environment chains by retained bytes", chains, top);
+    return 0;
+}
@@ -0,0 +1,242 @@
+/**
+ * @file dump.cpp
+ * @brief Writing heap snapshots
+ */
+
+#include "dump.hpp"
+#include "gc.hpp"
+#include "pool.hpp"
+#include "RE.hpp"
+#include <unistd.h>
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+const Assoc *globals = nullptr;
+std::atomic<bool> requested(false);
+
+const char *typeName(ValueType t) {
+    switch (t) {
+        case V_INT: return "integer";
+        case V_RATIONAL: return "rational";
+        case V_BOOL: return "boolean";
+        case V_SYM: return "symbol";
+        case V_NULL: return "null";
+        case V_STRING: return "string";
+        case V_PAIR: return "pair";
+        case V_PROC: return "procedure";
+        case V_RECORD: return "record";
+        case V_PROMISE: return "promise";
+        case V_ERROR: return "error";
+        case V_VALUES: return "values";
+        case V_PORT: return "port";
+        case V_EOF: return "eof";
+        case V_CHAR: return "char";
+        case V_BYTEVECTOR: return "bytevector";
+        case V_VECTOR: return "vector";
+        case V_FUTURE: return "future";
+        case V_FRAME: return "frame";
+        case V_HASHTABLE: return "hashtable";
+        case V_VOID: return "void";
+        default: return "other";
+    }
+}
+
+// The value and whatever storage only it owns
+size_t footprint(ValueBase *p) {
+    switch (p->v_type) {
+        case V_INT: return sizeof(Integer);
+        case V_RATIONAL: return sizeof(Rational);
+        case V_SYM: return sizeof(Symbol) + static_cast<Symbol *>(p)->s.capacity();
+        case V_STRING: {
+            String *s = static_cast<String *>(p);
+            return sizeof(String) + (s->text.use_count() == 1 ? s->text->length : 0);
+        }
+        case V_PAIR: return sizeof(Pair);
+        case V_PROC: {
+            Procedure *f = static_cast<Procedure *>(p);
+            return sizeof(Procedure) + f->parameters.capacity() * sizeof(std::string);
+        }
+        case V_RECORD: return sizeof(Record) + static_cast<Record *>(p)->slots.capacity() * sizeof(Value);
+        case V_PROMISE: return sizeof(Promise) + sizeof(PromiseBox);
+        case V_ERROR: return sizeof(ErrorObject) + static_cast<ErrorObject *>(p)->message.capacity();
+        case V_BYTEVECTOR: return sizeof(Bytevector) + static_cast<Bytevector *>(p)->bytes.capacity();
+        case V_VECTOR: {
+            Vector *v = static_cast<Vector *>(p);
+            return sizeof(Vector) + v->ints.capacity() * sizeof(int) + v->items.capacity() * sizeof(Value);
+        }
+        case V_FRAME: return sizeof(AssocList) + static_cast<AssocList *>(p)->x.capacity();
+        case V_HASHTABLE: {
+            Hashtable *t = static_cast<Hashtable *>(p);
+            return sizeof(Hashtable) + t->entries.bucket_count() * sizeof(void *) +
+                   t->entries.size() * (sizeof(Hashtable::Entry) + 2 * sizeof(void *) + sizeof(size_t));
+        }
+        default: return sizeof(ValueBase);
+    }
+}
+
+std::string label(ValueBase *p) {
+    switch (p->v_type) {
+        case V_PROC: {
+            Procedure *f = static_cast<Procedure *>(p);
+            if (f->cases) {
+                return "case-lambda";
+            }
+            std::string s = "(";
+            for (size_t i = 0; i < f->parameters.size(); i++) {
+                s += (i > 0 ? " " : "") + f->parameters[i];
+            }
+            if (!f->rest.empty()) {
+                s += (f->parameters.empty() ? ". " : " . ") + f->rest;
+            }
+            return s + ")";
+        }
+        case V_FRAME: return static_cast<AssocList *>(p)->x;
+        case V_SYM: return static_cast<Symbol *>(p)->s;
+        case V_RECORD: return static_cast<Record *>(p)->type->name;
+        default: return "";
+    }
+}
+
+struct Graph {
+    std::vector<ValueBase *> nodes;
+    std::unordered_map<ValueBase *, size_t> ids;
+    std::vector<size_t> exact_in;    ///< References accounting for one count each
+
+    size_t add(ValueBase *p) {
+        auto it = ids.find(p);
+        if (it != ids.end()) {
+            return it->second;
+        }
+        ids.emplace(p, nodes.size());
+        nodes.push_back(p);
+        exact_in.push_back(0);
+        return nodes.size() - 1;
+    }
+};
+
+struct EdgeVisitor : GcVisitor {
+    Graph &g;
+    std::vector<size_t> to;
+    EdgeVisitor(Graph &g) : GcVisitor(false), g(g) {}
+    virtual void visit(ValueBase *p) override {
+        if (!p->immortal) {
+            to.push_back(g.add(p));
+        }
+    }
+};
+
+struct InVisitor : GcVisitor {
+    Graph &g;
+    InVisitor(Graph &g) : GcVisitor(true), g(g) {}
+    virtual void visit(ValueBase *p) override {
+        auto it = g.ids.find(p);
+        if (it != g.ids.end()) {
+            g.exact_in[it->second]++;
+        }
+    }
+};
+
+void onSignal(int) {
+    requested.store(true, std::memory_order_relaxed);
+    gcRequestStep();
+}
+
+}
+
+void heapDumpGlobals(const Assoc *env) {
+    globals = env;
+}
+
+size_t dumpHeap(const std::string &path) {
+    if (onPoolWorker() || !poolIdle()) {
+        throw RuntimeError("dump-heap needs the thread pool idle");
+    }
+    std::ofstream out(path);
+    if (!out) {
+        throw RuntimeError("dump-heap cannot write " + path);
+    }
+    size_t count = 0;
+    gcWithContainers([&](const std::vector<ValueBase *> &containers) {
+        Graph g;
+        for (ValueBase *p : containers) {
+            if (!p->immortal) {
+                g.add(p);
+            }
+        }
+        std::vector<std::pair<size_t, size_t>> edges;
+        EdgeVisitor edge(g);
+        // Leaves found along the way join the end of the list
+        for (size_t i = 0; i < g.nodes.size(); i++) {
+            edge.to.clear();
+            g.nodes[i]->traverse(edge);
+            for (size_t to : edge.to) {
+                edges.emplace_back(i, to);
+            }
+        }
+        InVisitor in(g);
+        for (size_t i = 0; i < g.nodes.size(); i++) {
+            g.nodes[i]->traverse(in);
+        }
+        out << "scheme-heap-dump 1\n";
+        for (size_t i = 0; i < g.nodes.size(); i++) {
+            ValueBase *p = g.nodes[i];
+            int64_t external = referenceCount(p) - (int64_t)g.exact_in[i];
+            out << "n " << i << ' ' << typeName(p->v_type) << ' ' << footprint(p) << ' '
+                << (external > 0 ? external : 0);
+            std::string s = label(p);
+            if (!s.empty()) {
+                out << ' ' << s;
+            }
+            out << '\n';
+        }
+        for (auto &e : edges) {
+            out << "e " << e.first << ' ' << e.second << '\n';
+        }
+        if (globals != nullptr) {
+            for (AssocList *a = globals->get(); a != nullptr; a = a->next.get()) {
+                auto binding = g.ids.find(a);
+                if (binding == g.ids.end()) {
+                    continue;
+                }
+                auto value = g.ids.find(a->v.get());
+                out << "g " << binding->second << ' '
+                    << (value != g.ids.end() ? (long)value->second : -1L) << ' ' << a->x << '\n';
+            }
+        }
+        count = g.nodes.size();
+    });
+    if (!out.flush()) {
+        throw RuntimeError("dump-heap cannot write " + path);
+    }
+    return count;
+}
+
+void installHeapDumpSignal() {
+    std::signal(SIGUSR1, onSignal);
+}
+
+void heapDumpPoll() {
+    if (!requested.load(std::memory_order_relaxed) || onPoolWorker() || !poolIdle()) {
+        return;
+    }
+    requested = false;
+    std::string path;
+    if (const char *env = std::getenv("SCHEME_HEAP_DUMP")) {
+        path = env;
+    } else {
+        path = "heap-" + std::to_string((long)getpid()) + ".dump";
+    }
+    try {
+        size_t n = dumpHeap(path);
+        std::fprintf(stderr, "heap dump: %zu values to %s\n", n, path.c_str());
+    } catch (const RuntimeError &e) {
+        std::fprintf(stderr, "heap dump: %s\n", e.message().c_str());
+    }
+}
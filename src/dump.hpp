@@ -0,0 +1,55 @@
+#ifndef DUMP_HPP
+#define DUMP_HPP
+
+/**
+ * @file dump.hpp
+ * @brief Heap snapshots, for finding out what holds on to memory
+ *
+ * A dump is a text file listing every live value the collector's containers
+ * reach, one line each, then the references between them and the top-level
+ * bindings:
+ *
+ *   scheme-heap-dump 1
+ *   n <id> <type> <bytes> <external> [<label>]
+ *   e <from> <to>
+ *   g <binding> <value> <name>
+ *
+ * bytes counts the value and the storage it owns alone; external is the
+ * part of its reference count no other value accounts for, so values with
+ * a positive one are roots (the C++ stack, expression literals, the
+ * top-level environment). A label is the parameter list of a procedure,
+ * the variable of an environment frame, the name of a symbol or the type of
+ * a record. The value of a binding is -1 when it is not in the dump.
+ * Immortal values are left out.
+ *
+ * (dump-heap "file") writes one. SIGUSR1 asks for one in SCHEME_HEAP_DUMP
+ * (heap-<pid>.dump by default), written by the main thread at its next
+ * allocation or top-level form. heap-analyze reads a dump and reports the
+ * retained size of procedures, top-level bindings and environment chains.
+ */
+
+#include "value.hpp"
+#include <string>
+
+/**
+ * @brief Environment whose bindings a dump lists as top-level ones
+ */
+void heapDumpGlobals(const Assoc *);
+
+/**
+ * @brief Write a dump to the given file and yield how many values it lists
+ * Only on the main thread while no pool task is in flight.
+ */
+size_t dumpHeap(const std::string &);
+
+/**
+ * @brief Make SIGUSR1 ask for a dump
+ */
+void installHeapDumpSignal();
+
+/**
+ * @brief Write the dump SIGUSR1 asked for, if any
+ */
+void heapDumpPoll();
+
+#endif
@@ -12,10 +12,18 @@
 #include "expr.hpp"
 #include "RE.hpp"
 #include "syntax.hpp"
+#include "simd.hpp"
+#include "pool.hpp"
+#include "gc.hpp"
+#include "heap.hpp"
+#include "dump.hpp"
 #include <cstring>
 #include <vector>
 #include <map>
 #include <climits>
+#include <cstdint>
+#include <algorithm>
+#include <sstream>
 
 extern std::map<std::string, ExprType> primitives;
 extern std::map<std::string, ExprType> reserved_words;
@@ -29,7 +37,7 @@ Value RationalNum::eval(Assoc &e) { // evaluation of a rational number
 }
 
 Value StringExpr::eval(Assoc &e) { // evaluation of a string
-    return StringV(s);
+    return Value(v);
 }
 
 Value True::eval(Assoc &e) { // evaluation of #t
@@ -49,17 +57,17 @@ Value Exit::eval(Assoc &e) { // (exit)
 }
 
 Value Unary::eval(Assoc &e) { // evaluation of single-operator primitive
-    return evalRator(rand->eval(e));
+    return evalRator(oneValue(rand->eval(e)));
 }
 
 Value Binary::eval(Assoc &e) { // evaluation of two-operators primitive
-    return evalRator(rand1->eval(e), rand2->eval(e));
+    return evalRator(oneValue(rand1->eval(e)), oneValue(rand2->eval(e)));
 }
 
 Value Variadic::eval(Assoc &e) { // evaluation of multi-operator primitive
     std::vector<Value> args;
     for (auto& r : rands) {
-        args.push_back(r->eval(e));
+        args.push_back(oneValue(r->eval(e)));
     }
     return evalRator(args);
 }
@@ -67,15 +75,20 @@ Value Variadic::eval(Assoc &e) { // evaluation of multi-operator primitive
 Value Var::eval(Assoc &e) { // evaluation of variable
     Value matched_value = find(x, e);
     if (matched_value.get() == nullptr) {
-        if (primitives.count(x)) {
-            // Return the primitive as a procedure
-            ExprType primType = primitives[x];
-            // Create a closure that represents this primitive
-            // For now, we'll create special procedure values for primitives
-            // This is handled by returning a special marker
-            throw RuntimeError("Primitive " + x + " used as variable without being called");
+        // One procedure per primitive, so (eq? car car) holds; the table is
+        // built once and only read afterwards, so lookups take no lock
+        static const std::map<std::string, Value> primitive_procs = [] {
+            std::map<std::string, Value> procs;
+            for (const auto &p : primitives) {
+                procs.emplace(p.first, ProcedureV({}, "args", true, Expr(new PrimitiveCall(p.first)), empty()));
+            }
+            return procs;
+        }();
+        auto it = primitive_procs.find(x);
+        if (it != primitive_procs.end()) {
+            return it->second;
         }
-        throw RuntimeError("Undefined variable: " + x);
+        throw RuntimeError("Undefined variable: ", x);
     }
     return matched_value;
 }
@@ -455,6 +468,30 @@ Value ListFunc::evalRator(const std::vector<Value> &args) { // list function
     return result;
 }
 
+Value Append::evalRator(const std::vector<Value> &args) { // append
+    if (args.size() == 0) {
+        return NullV();
+    }
+    // The last argument is shared, every other list is copied
+    Value result = args.back();
+    for (size_t i = args.size() - 1; i-- > 0;) {
+        std::vector<Value> elems;
+        Value current = args[i];
+        while (current->v_type == V_PAIR) {
+            Pair* p = dynamic_cast<Pair*>(current.get());
+            elems.push_back(p->car);
+            current = p->cdr;
+        }
+        if (current->v_type != V_NULL) {
+            throw RuntimeError("append requires proper lists");
+        }
+        for (size_t j = elems.size(); j-- > 0;) {
+            result = PairV(elems[j], result);
+        }
+    }
+    return result;
+}
+
 Value IsList::evalRator(const Value &rand) { // list?
     if (rand->v_type == V_NULL) {
         return BooleanV(true);
@@ -492,8 +529,12 @@ Value SetCar::evalRator(const Value &rand1, const Value &rand2) { // set-car!
         throw RuntimeError("set-car! requires a pair");
     }
     Pair* p = dynamic_cast<Pair*>(rand1.get());
+    if (p->immutable) {
+        throw RuntimeError("set-car! on a constant pair");
+    }
     // We need to modify the pair in place
     // Since Pair is shared_ptr, we can modify it directly
+    gcWriteBarrier(p->car);
     const_cast<Pair*>(p)->car = rand2;
     return VoidV();
 }
@@ -503,7 +544,11 @@ Value SetCdr::evalRator(const Value &rand1, const Value &rand2) { // set-cdr!
         throw RuntimeError("set-cdr! requires a pair");
     }
     Pair* p = dynamic_cast<Pair*>(rand1.get());
+    if (p->immutable) {
+        throw RuntimeError("set-cdr! on a constant pair");
+    }
     // We need to modify the pair in place
+    gcWriteBarrier(p->cdr);
     const_cast<Pair*>(p)->cdr = rand2;
     return VoidV();
 }
@@ -558,6 +603,419 @@ Value IsString::evalRator(const Value &rand) { // string?
     return BooleanV(rand->v_type == V_STRING);
 }
 
+static String* asString(const Value &v) {
+    if (v->v_type != V_STRING) {
+        throw RuntimeError("Expected a string");
+    }
+    return static_cast<String*>(v.get());
+}
+
+static size_t asIndex(const Value &v, size_t bound) {
+    if (v->v_type != V_INT || dynamic_cast<Integer*>(v.get())->n < 0 ||
+        (size_t)dynamic_cast<Integer*>(v.get())->n > bound) {
+        throw RuntimeError("Index out of range");
+    }
+    return dynamic_cast<Integer*>(v.get())->n;
+}
+
+Value StringAppend::evalRator(const std::vector<Value> &args) { // string-append
+    if (args.empty()) {
+        return StringV("");
+    }
+    Value result = args[0];
+    asString(result);
+    for (size_t i = 1; i < args.size(); i++) {
+        result = StringAppendV(*static_cast<String*>(result.get()), *asString(args[i]));
+    }
+    return result;
+}
+
+Value Substring::evalRator(const std::vector<Value> &args) { // substring
+    if (args.size() < 2 || args.size() > 3) {
+        throw RuntimeError("Wrong number of arguments for substring");
+    }
+    String* s = asString(args[0]);
+    size_t start = asIndex(args[1], s->length);
+    size_t end = args.size() == 3 ? asIndex(args[2], s->length) : s->length;
+    if (end < start) {
+        throw RuntimeError("Index out of range");
+    }
+    return SubstringV(*s, start, end - start);
+}
+
+Value StringLength::evalRator(const Value &rand) { // string-length
+    return IntegerV(asString(rand)->length);
+}
+
+Value StringRef::evalRator(const Value &rand1, const Value &rand2) { // string-ref
+    String* s = asString(rand1);
+    size_t i = asIndex(rand2, s->length);
+    if (i == s->length) {
+        throw RuntimeError("Index out of range");
+    }
+    return CharV(s->at(i));
+}
+
+Value StringToSymbol::evalRator(const Value &rand) { // string->symbol
+    return SymbolV(asString(rand)->str());
+}
+
+Value SymbolToString::evalRator(const Value &rand) { // symbol->string
+    if (rand->v_type != V_SYM) {
+        throw RuntimeError("Expected a symbol");
+    }
+    return StringV(dynamic_cast<Symbol*>(rand.get())->s);
+}
+
+Value StringToList::evalRator(const Value &rand) { // string->list
+    String* s = asString(rand);
+    const char* chars = s->text->chars().data() + s->offset;
+    Value result = NullV();
+    for (size_t i = s->length; i-- > 0;) {
+        result = PairV(CharV(chars[i]), result);
+    }
+    return result;
+}
+
+Value ListToString::evalRator(const Value &rand) { // list->string
+    std::string chars;
+    Value p = rand;
+    while (p->v_type == V_PAIR) {
+        Pair* pair = static_cast<Pair*>(p.get());
+        if (pair->car->v_type != V_CHAR) {
+            throw RuntimeError("Expected a list of characters");
+        }
+        chars.push_back(static_cast<Char*>(pair->car.get())->c);
+        p = pair->cdr;
+    }
+    if (p->v_type != V_NULL) {
+        throw RuntimeError("Expected a list of characters");
+    }
+    return StringV(chars);
+}
+
+static Bytevector* asBytevector(const Value &v) {
+    if (v->v_type != V_BYTEVECTOR) {
+        throw RuntimeError("Expected a bytevector");
+    }
+    return static_cast<Bytevector*>(v.get());
+}
+
+static unsigned char asByte(const Value &v) {
+    if (v->v_type != V_INT || dynamic_cast<Integer*>(v.get())->n < 0 || dynamic_cast<Integer*>(v.get())->n > 255) {
+        throw RuntimeError("Expected a byte");
+    }
+    return (unsigned char)dynamic_cast<Integer*>(v.get())->n;
+}
+
+Value MakeBytevector::evalRator(const std::vector<Value> &args) { // make-bytevector
+    size_t n = asIndex(args[0], INT_MAX);
+    return BytevectorV(n, args.size() > 1 ? asByte(args[1]) : 0);
+}
+
+Value BytevectorFunc::evalRator(const std::vector<Value> &args) { // bytevector
+    Value result = BytevectorV(args.size(), 0);
+    Bytevector* bv = static_cast<Bytevector*>(result.get());
+    for (size_t i = 0; i < args.size(); i++) {
+        bv->bytes[i] = asByte(args[i]);
+    }
+    return result;
+}
+
+Value IsBytevector::evalRator(const Value &rand) { // bytevector?
+    return BooleanV(rand->v_type == V_BYTEVECTOR);
+}
+
+Value BytevectorLength::evalRator(const Value &rand) { // bytevector-length
+    return IntegerV(asBytevector(rand)->bytes.size());
+}
+
+Value BytevectorRef::evalRator(const Value &rand1, const Value &rand2) { // bytevector-u8-ref
+    Bytevector* bv = asBytevector(rand1);
+    size_t i = asIndex(rand2, bv->bytes.size());
+    if (i == bv->bytes.size()) {
+        throw RuntimeError("Index out of range");
+    }
+    return IntegerV(bv->bytes[i]);
+}
+
+Value BytevectorSet::evalRator(const std::vector<Value> &args) { // bytevector-u8-set!
+    Bytevector* bv = asBytevector(args[0]);
+    size_t i = asIndex(args[1], bv->bytes.size());
+    if (i == bv->bytes.size()) {
+        throw RuntimeError("Index out of range");
+    }
+    bv->bytes[i] = asByte(args[2]);
+    return VoidV();
+}
+
+// Read the optional [start [end]] arguments beginning at args[first]
+static void byteRange(const std::vector<Value> &args, size_t first, size_t size, size_t &start, size_t &end) {
+    start = args.size() > first ? asIndex(args[first], size) : 0;
+    end = args.size() > first + 1 ? asIndex(args[first + 1], size) : size;
+    if (end < start) {
+        throw RuntimeError("Index out of range");
+    }
+}
+
+Value BytevectorCopy::evalRator(const std::vector<Value> &args) { // bytevector-copy!
+    Bytevector* to = asBytevector(args[0]);
+    size_t at = asIndex(args[1], to->bytes.size());
+    Bytevector* from = asBytevector(args[2]);
+    size_t start, end;
+    byteRange(args, 3, from->bytes.size(), start, end);
+    if (end - start > to->bytes.size() - at) {
+        throw RuntimeError("Index out of range");
+    }
+    if (end > start) {
+        // The ranges may overlap when copying within one bytevector
+        std::memmove(to->bytes.data() + at, from->bytes.data() + start, end - start);
+    }
+    return VoidV();
+}
+
+Value BytevectorFill::evalRator(const std::vector<Value> &args) { // bytevector-fill!
+    Bytevector* bv = asBytevector(args[0]);
+    unsigned char fill = asByte(args[1]);
+    size_t start, end;
+    byteRange(args, 2, bv->bytes.size(), start, end);
+    if (end > start) {
+        std::memset(bv->bytes.data() + start, fill, end - start);
+    }
+    return VoidV();
+}
+
+static Vector* asVector(const Value &v) {
+    if (v->v_type != V_VECTOR) {
+        throw RuntimeError("Expected a vector");
+    }
+    return static_cast<Vector*>(v.get());
+}
+
+static Vector* asFixnumVector(const Value &v) {
+    Vector* vec = asVector(v);
+    if (!vec->packed) {
+        throw RuntimeError("Expected a vector of integers");
+    }
+    return vec;
+}
+
+Value MakeVector::evalRator(const std::vector<Value> &args) { // make-vector
+    size_t n = asIndex(args[0], INT_MAX);
+    return VectorV(n, args.size() > 1 ? args[1] : IntegerV(0));
+}
+
+Value VectorFunc::evalRator(const std::vector<Value> &args) { // vector
+    return VectorV(std::vector<Value>(args));
+}
+
+Value IsVector::evalRator(const Value &rand) { // vector?
+    return BooleanV(rand->v_type == V_VECTOR);
+}
+
+Value VectorLength::evalRator(const Value &rand) { // vector-length
+    return IntegerV(asVector(rand)->size());
+}
+
+Value VectorRef::evalRator(const Value &rand1, const Value &rand2) { // vector-ref
+    Vector* vec = asVector(rand1);
+    size_t i = asIndex(rand2, vec->size());
+    if (i == vec->size()) {
+        throw RuntimeError("Index out of range");
+    }
+    return vec->ref(i);
+}
+
+Value VectorSet::evalRator(const std::vector<Value> &args) { // vector-set!
+    Vector* vec = asVector(args[0]);
+    size_t i = asIndex(args[1], vec->size());
+    if (i == vec->size()) {
+        throw RuntimeError("Index out of range");
+    }
+    vec->set(i, args[2]);
+    return VoidV();
+}
+
+Value VectorToList::evalRator(const Value &rand) { // vector->list
+    Vector* vec = asVector(rand);
+    Value result = NullV();
+    for (size_t i = vec->size(); i-- > 0;) {
+        result = PairV(vec->ref(i), result);
+    }
+    return result;
+}
+
+Value ListToVector::evalRator(const Value &rand) { // list->vector
+    std::vector<Value> items;
+    Value p = rand;
+    while (p->v_type == V_PAIR) {
+        items.push_back(static_cast<Pair*>(p.get())->car);
+        p = static_cast<Pair*>(p.get())->cdr;
+    }
+    if (p->v_type != V_NULL) {
+        throw RuntimeError("Expected a list");
+    }
+    return VectorV(std::move(items));
+}
+
+Value VectorSum::evalRator(const Value &rand) { // vector-sum
+    const std::vector<int> &a = asFixnumVector(rand)->ints;
+    return IntegerV(intKernels().sum(a.data(), a.size()));
+}
+
+Value VectorDot::evalRator(const Value &rand1, const Value &rand2) { // vector-dot
+    const std::vector<int> &a = asFixnumVector(rand1)->ints;
+    const std::vector<int> &b = asFixnumVector(rand2)->ints;
+    if (a.size() != b.size()) {
+        throw RuntimeError("Vectors differ in length");
+    }
+    return IntegerV(intKernels().dot(a.data(), b.data(), a.size()));
+}
+
+Value VectorMax::evalRator(const Value &rand) { // vector-max
+    const std::vector<int> &a = asFixnumVector(rand)->ints;
+    if (a.empty()) {
+        throw RuntimeError("vector-max of an empty vector");
+    }
+    return IntegerV(intKernels().max(a.data(), a.size()));
+}
+
+Value VectorAdd::evalRator(const Value &rand1, const Value &rand2) { // vector+
+    const std::vector<int> &a = asFixnumVector(rand1)->ints;
+    const std::vector<int> &b = asFixnumVector(rand2)->ints;
+    if (a.size() != b.size()) {
+        throw RuntimeError("Vectors differ in length");
+    }
+    std::vector<int> out(a.size());
+    intKernels().add(a.data(), b.data(), out.data(), a.size());
+    return VectorV(std::move(out));
+}
+
+Value VectorMap::evalRator(const std::vector<Value> &args) { // vector-map
+    if (args.size() < 2) {
+        throw RuntimeError("Wrong number of arguments for vector-map");
+    }
+    std::vector<Vector*> vecs;
+    size_t n = SIZE_MAX;
+    for (size_t i = 1; i < args.size(); i++) {
+        vecs.push_back(asVector(args[i]));
+        n = std::min(n, vecs.back()->size());
+    }
+    // Primitive arithmetic over two packed vectors never enters the interpreter
+    Procedure* proc = args[0]->v_type == V_PROC ? static_cast<Procedure*>(args[0].get()) : nullptr;
+    if (proc && !proc->cases && proc->e->e_type == E_PRIMITIVE_CALL && vecs.size() == 2 &&
+        vecs[0]->packed && vecs[1]->packed) {
+        const std::string &op = static_cast<PrimitiveCall*>(proc->e.get())->name;
+        void (*kernel)(const int *, const int *, int *, size_t) =
+            op == "+" ? intKernels().add : op == "-" ? intKernels().sub : op == "*" ? intKernels().mul : nullptr;
+        if (kernel) {
+            std::vector<int> out(n);
+            kernel(vecs[0]->ints.data(), vecs[1]->ints.data(), out.data(), n);
+            return VectorV(std::move(out));
+        }
+    }
+    std::vector<Value> results;
+    results.reserve(n);
+    std::vector<Value> call_args(vecs.size(), Value(nullptr));
+    for (size_t i = 0; i < n; i++) {
+        for (size_t j = 0; j < vecs.size(); j++) {
+            call_args[j] = vecs[j]->ref(i);
+        }
+        results.push_back(applyProcedure(args[0], call_args));
+    }
+    return VectorV(std::move(results));
+}
+
+static Hashtable* asHashtable(const Value &v) {
+    if (v->v_type != V_HASHTABLE) {
+        throw RuntimeError("Expected a hashtable");
+    }
+    return static_cast<Hashtable*>(v.get());
+}
+
+Value MakeHashtable::eval(Assoc &e) { // make-eq-hashtable, make-weak-eq-hashtable
+    return HashtableV(e_type == E_MAKE_WEAK_EQ_HASHTABLE);
+}
+
+Value IsHashtable::evalRator(const Value &rand) { // hashtable?
+    return BooleanV(rand->v_type == V_HASHTABLE);
+}
+
+Value HashtableSize::evalRator(const Value &rand) { // hashtable-size
+    return IntegerV((int)asHashtable(rand)->size());
+}
+
+Value HashtableRef::evalRator(const std::vector<Value> &args) { // hashtable-ref
+    Value found = asHashtable(args[0])->ref(args[1]);
+    return found.get() != nullptr ? found : args[2];
+}
+
+Value HashtableSet::evalRator(const std::vector<Value> &args) { // hashtable-set!
+    asHashtable(args[0])->set(args[1], args[2]);
+    return VoidV();
+}
+
+Value HashtableContains::evalRator(const Value &rand1, const Value &rand2) { // hashtable-contains?
+    return BooleanV(asHashtable(rand1)->ref(rand2).get() != nullptr);
+}
+
+Value HashtableDelete::evalRator(const Value &rand1, const Value &rand2) { // hashtable-delete!
+    asHashtable(rand1)->remove(rand2);
+    return VoidV();
+}
+
+Value HashtableKeys::evalRator(const Value &rand) { // hashtable-keys
+    return VectorV(asHashtable(rand)->keys());
+}
+
+Value HashtableClear::evalRator(const Value &rand) { // hashtable-clear!
+    asHashtable(rand)->clear();
+    return VoidV();
+}
+
+static char asChar(const Value &v) {
+    if (v->v_type != V_CHAR) {
+        throw RuntimeError("Expected a character");
+    }
+    return static_cast<Char*>(v.get())->c;
+}
+
+Value IsChar::evalRator(const Value &rand) { // char?
+    return BooleanV(rand->v_type == V_CHAR);
+}
+
+Value CharToInteger::evalRator(const Value &rand) { // char->integer
+    return IntegerV((unsigned char)asChar(rand));
+}
+
+Value IntegerToChar::evalRator(const Value &rand) { // integer->char
+    if (rand->v_type != V_INT) {
+        throw RuntimeError("Expected an integer");
+    }
+    int n = dynamic_cast<Integer*>(rand.get())->n;
+    if (n < 0 || n > 255) {
+        throw RuntimeError("Character code out of range");
+    }
+    return CharV((char)n);
+}
+
+Value CharEq::evalRator(const Value &rand1, const Value &rand2) { // char=?
+    return BooleanV(asChar(rand1) == asChar(rand2));
+}
+
+Value CharLess::evalRator(const Value &rand1, const Value &rand2) { // char<?
+    return BooleanV((unsigned char)asChar(rand1) < (unsigned char)asChar(rand2));
+}
+
+Value NumberToString::evalRator(const Value &rand) { // number->string
+    if (rand->v_type != V_INT && rand->v_type != V_RATIONAL) {
+        throw RuntimeError("Expected a number");
+    }
+    std::ostringstream os;
+    rand->show(os);
+    return StringV(os.str());
+}
+
 Value Begin::eval(Assoc &e) {
     if (es.size() == 0) {
         return VoidV();
@@ -577,6 +1035,8 @@ Value syntaxToValue(Syntax &s, Assoc &env) {
         return RationalV(rat->numerator, rat->denominator);
     } else if (auto str = dynamic_cast<StringSyntax*>(s.get())) {
         return StringV(str->s);
+    } else if (auto ch = dynamic_cast<CharSyntax*>(s.get())) {
+        return CharV(ch->c);
     } else if (auto sym = dynamic_cast<SymbolSyntax*>(s.get())) {
         return SymbolV(sym->s);
     } else if (auto trueSyn = dynamic_cast<TrueSyntax*>(s.get())) {
@@ -601,6 +1061,10 @@ Value Quote::eval(Assoc& e) {
     return syntaxToValue(s, e);
 }
 
+Value Const::eval(Assoc &e) {
+    return Value(v);
+}
+
 Value AndVar::eval(Assoc &e) { // and with short-circuit evaluation
     Value result = BooleanV(true);
     for (auto& expr : rands) {
@@ -645,7 +1109,7 @@ Value Not::evalRator(const Value &rand) { // not
 }
 
 Value If::eval(Assoc &e) {
-    Value condValue = cond->eval(e);
+    Value condValue = oneValue(cond->eval(e));
     bool isTrue = true;
     if (condValue->v_type == V_BOOL) {
         Boolean* b = dynamic_cast<Boolean*>(condValue.get());
@@ -669,7 +1133,7 @@ Value Cond::eval(Assoc &env) {
             // Check if the first element is a symbol "else"
             // This requires checking if it's a Var expression that evaluates to "else"
             // For now, we'll evaluate it
-            Value condValue = clause[0]->eval(env);
+            Value condValue = oneValue(clause[0]->eval(env));
             bool isTrue = true;
             if (condValue->v_type == V_BOOL) {
                 Boolean* b = dynamic_cast<Boolean*>(condValue.get());
@@ -692,49 +1156,583 @@ Value Cond::eval(Assoc &env) {
     return VoidV();
 }
 
+Value Case::eval(Assoc &env) {
+    Value k = key->eval(env);
+    int clause = -1;
+    switch (k->v_type) {
+        case V_INT: {
+            int n = dynamic_cast<Integer*>(k.get())->n;
+            if (!fix_table.empty()) {
+                long long at = (long long)n - fix_min;
+                if (at >= 0 && at < (long long)fix_table.size()) {
+                    clause = fix_table[at];
+                }
+            } else {
+                auto it = fix_map.find(n);
+                if (it != fix_map.end()) {
+                    clause = it->second;
+                }
+            }
+            break;
+        }
+        case V_SYM: {
+            auto it = sym_map.find(dynamic_cast<Symbol*>(k.get())->s);
+            if (it != sym_map.end()) {
+                clause = it->second;
+            }
+            break;
+        }
+        case V_BOOL:
+            clause = bool_clause[dynamic_cast<Boolean*>(k.get())->b ? 1 : 0];
+            break;
+        case V_CHAR:
+            if (!char_table.empty()) {
+                clause = char_table[(unsigned char)static_cast<Char*>(k.get())->c];
+            }
+            break;
+        case V_NULL:
+            clause = null_clause;
+            break;
+        default:
+            break;
+    }
+    if (clause < 0) {
+        clause = else_clause;
+    }
+    if (clause < 0) {
+        return VoidV();
+    }
+    return bodies[clause]->eval(env);
+}
+
 Value Lambda::eval(Assoc &env) {
-    return ProcedureV(x, e, env);
+    if (rest.empty()) {
+        return ProcedureV(x, e, env);
+    }
+    return ProcedureV(x, rest, rest_used, e, env);
 }
 
-Value Apply::eval(Assoc &e) {
-    Value ratorValue = rator->eval(e);
-    if (ratorValue->v_type != V_PROC) {throw RuntimeError("Attempt to apply a non-procedure");}
+Value CaseLambda::eval(Assoc &env) {
+    std::vector<Value> closures;
+    for (auto &c : clauses) {
+        closures.push_back(c->eval(env));
+    }
+    std::shared_ptr<CaseTable> table = std::make_shared<CaseTable>();
+    for (int k : by_arity) {
+        table->by_arity.push_back(k < 0 ? Value(nullptr) : closures[k]);
+    }
+    if (tail >= 0) {
+        table->tail = closures[tail];
+    }
+    return CaseProcedureV(table, env);
+}
 
-    Procedure* clos_ptr = dynamic_cast<Procedure*>(ratorValue.get());
+Value ApplyProc::evalRator(const std::vector<Value> &args) { // apply
+    if (args.size() < 2) {
+        throw RuntimeError("Wrong number of arguments for apply");
+    }
+    std::vector<Value> spread(args.begin() + 1, args.end() - 1);
+    Value p = args.back();
+    while (p->v_type == V_PAIR) {
+        Pair* pair = dynamic_cast<Pair*>(p.get());
+        spread.push_back(pair->car);
+        p = pair->cdr;
+    }
+    if (p->v_type != V_NULL) {
+        throw RuntimeError("The last argument of apply must be a list");
+    }
+    return applyProcedure(args[0], spread);
+}
+
+namespace {
+// True when e is the variable %i bound by a PrimitiveCall frame
+bool isArg(const Expr &e, const std::string &name) {
+    return e->e_type == E_VAR && static_cast<Var*>(e.get())->x == name;
+}
+}
 
-    //TODO: TO COMPLETE THE ARGUMENT PARSER LOGIC
+const PrimitiveCall::Form &PrimitiveCall::form(size_t n) {
+    if (n < FAST_ARITIES) {
+        Form* cached = fast[n].load(std::memory_order_acquire);
+        if (cached != nullptr) {
+            return *cached;
+        }
+    }
+    std::lock_guard<std::mutex> lock(cache_lock);
+    auto it = by_arity.find(n);
+    if (it == by_arity.end()) {
+        // Parse (name %0 %1 ...) once for this argument count
+        std::vector<std::string> names;
+        List* form = new List();
+        form->stxs.push_back(Syntax(new SymbolSyntax(name)));
+        for (size_t i = 0; i < n; i++) {
+            names.push_back("%" + std::to_string(i));
+            form->stxs.push_back(Syntax(new SymbolSyntax(names.back())));
+        }
+        Assoc top = empty();
+        Expr body = Syntax(form)->parse(top);
+        // The operands must be exactly %0 %1 ... in order to skip the frame
+        Form::Kind kind = Form::FRAME;
+        if (Unary* u = dynamic_cast<Unary*>(body.get())) {
+            if (n == 1 && isArg(u->rand, names[0])) kind = Form::UNARY;
+        } else if (Binary* b = dynamic_cast<Binary*>(body.get())) {
+            if (n == 2 && isArg(b->rand1, names[0]) && isArg(b->rand2, names[1])) kind = Form::BINARY;
+        } else if (Variadic* v = dynamic_cast<Variadic*>(body.get())) {
+            bool in_order = v->rands.size() == n;
+            for (size_t i = 0; in_order && i < n; i++) {
+                in_order = isArg(v->rands[i], names[i]);
+            }
+            if (in_order) kind = Form::VARIADIC;
+        }
+        it = by_arity.emplace(n, Form(kind, body, names)).first;
+        if (n < FAST_ARITIES) {
+            fast[n].store(&it->second, std::memory_order_release);
+        }
+    }
+    return it->second;
+}
+
+Value PrimitiveCall::call(const std::vector<Value> &args) {
+    const Form &f = form(args.size());
+    switch (f.kind) {
+        case Form::UNARY:
+            return static_cast<Unary*>(f.body.get())->evalRator(args[0]);
+        case Form::BINARY:
+            return static_cast<Binary*>(f.body.get())->evalRator(args[0], args[1]);
+        case Form::VARIADIC:
+            return static_cast<Variadic*>(f.body.get())->evalRator(args);
+        default:
+            break;
+    }
+    Assoc frame = empty();
+    for (size_t i = 0; i < args.size(); i++) {
+        frame = extend(f.names[i], args[i], frame);
+    }
+    return f.body->eval(frame);
+}
+
+Value PrimitiveCall::eval(Assoc &e) {
     std::vector<Value> args;
-    for (auto& r : rand) {
-        args.push_back(r->eval(e));
+    for (Value p = find("args", e); p->v_type == V_PAIR; p = dynamic_cast<Pair*>(p.get())->cdr) {
+        args.push_back(dynamic_cast<Pair*>(p.get())->car);
+    }
+    return call(args);
+}
+
+// Call a procedure value on already evaluated arguments
+Value applyProcedure(const Value &proc, const std::vector<Value> &args) {
+    if (proc->v_type != V_PROC) {throw RuntimeError("Attempt to apply a non-procedure");}
+
+    Procedure* clos_ptr = dynamic_cast<Procedure*>(proc.get());
+    if (clos_ptr->cases) {
+        const CaseTable &table = *clos_ptr->cases;
+        const Value &clause = args.size() < table.by_arity.size() ? table.by_arity[args.size()] : table.tail;
+        if (clause.get() == nullptr) throw RuntimeError("No case-lambda clause takes this many arguments");
+        return applyProcedure(clause, args);
+    }
+    if (clos_ptr->e->e_type == E_PRIMITIVE_CALL) {
+        // Skip packing the arguments into the rest list
+        return static_cast<PrimitiveCall*>(clos_ptr->e.get())->call(args);
+    }
+    size_t fixed = clos_ptr->parameters.size();
+    if (args.size() < fixed || (clos_ptr->rest.empty() && args.size() != fixed)) {
+        throw RuntimeError("Wrong number of arguments");
     }
-    if (args.size() != clos_ptr->parameters.size()) throw RuntimeError("Wrong number of arguments");
 
-    //TODO: TO COMPLETE THE PARAMETERS' ENVIRONMENT LOGIC
     Assoc param_env = clos_ptr->env;
-    for (size_t i = 0; i < clos_ptr->parameters.size(); i++) {
+    for (size_t i = 0; i < fixed; i++) {
         param_env = extend(clos_ptr->parameters[i], args[i], param_env);
     }
+    if (clos_ptr->rest_used) {
+        Value rest = NullV();
+        for (size_t i = args.size(); i-- > fixed;) {
+            rest = PairV(args[i], rest);
+        }
+        param_env = extend(clos_ptr->rest, rest, param_env);
+    }
 
     return clos_ptr->e->eval(param_env);
 }
 
+Value Apply::eval(Assoc &e) {
+    Value ratorValue = rator->eval(e);
+    if (ratorValue->v_type != V_PROC) {throw RuntimeError("Attempt to apply a non-procedure");}
+
+    std::vector<Value> args;
+    for (auto& r : rand) {
+        args.push_back(oneValue(r->eval(e)));
+    }
+    return applyProcedure(ratorValue, args);
+}
+
+namespace {
+// A continuation stops being invocable once its call/cc returns
+struct ContinuationExtent {
+    std::shared_ptr<ContinuationState> state;
+    ContinuationExtent(const std::shared_ptr<ContinuationState> &s) : state(s) {}
+    ~ContinuationExtent() { state->active = false; }
+};
+}
+
+Value CallCC::evalRator(const Value &rand) { // call/cc
+    std::shared_ptr<ContinuationState> state = std::make_shared<ContinuationState>();
+    ContinuationExtent extent(state);
+    Value k = ProcedureV({"value"}, Expr(new Continue(state)), empty());
+    try {
+        return applyProcedure(rand, {k});
+    } catch (const ContinuationThrow &thrown) {
+        if (thrown.target != state) {
+            throw;
+        }
+        return thrown.v;
+    }
+}
+
+Value Continue::eval(Assoc &e) {
+    if (!target->active) {
+        throw RuntimeError("Re-entering a continuation whose extent has ended is not supported");
+    }
+    throw ContinuationThrow(target, find("value", e));
+}
+
+Value DynamicWind::evalRator(const std::vector<Value> &args) { // dynamic-wind
+    applyProcedure(args[0], {});
+    Value result = VoidV();
+    try {
+        result = applyProcedure(args[1], {});
+    } catch (...) {
+        // Escapes and errors leave the extent too
+        applyProcedure(args[2], {});
+        throw;
+    }
+    if (result->v_type == V_VALUES) {
+        // The after thunk may use the values register itself
+        std::vector<Value> vals;
+        takeValues(result, vals);
+        applyProcedure(args[2], {});
+        return ValuesV(vals);
+    }
+    applyProcedure(args[2], {});
+    return result;
+}
+
 // Global environment pointer - we need to define this as extern in Def.hpp
 extern Assoc global_env;
 
 Value Define::eval(Assoc &env) {
-    Value value = e->eval(env);
-    // Check if variable already exists in global environment
-    // For simplicity, we just add it to the current environment
-    // In a real implementation, define should only work at top level
-    extend(var, value, env);
+    if (e->e_type == E_LAMBDA) {
+        // Bind first so the procedure's closure can see its own name
+        insert(var, VoidV(), env);
+        modify(var, oneValue(e->eval(env)), env);
+    } else {
+        insert(var, oneValue(e->eval(env)), env);
+    }
     return VoidV();
 }
 
+Value RecordMake::eval(Assoc &env) {
+    Value record = RecordV(type);
+    Record* r = static_cast<Record*>(record.get());
+    for (size_t i = 0; i < rands.size(); i++) {
+        r->slots[slot[i]] = oneValue(rands[i]->eval(env));
+    }
+    return record;
+}
+
+Value RecordIs::evalRator(const Value &rand) {
+    return BooleanV(rand->v_type == V_RECORD && static_cast<Record*>(rand.get())->type == type);
+}
+
+Value RecordRef::evalRator(const Value &rand) {
+    if (rand->v_type != V_RECORD || static_cast<Record*>(rand.get())->type != type) {
+        throw RuntimeError("Record accessor applied to wrong type");
+    }
+    return static_cast<Record*>(rand.get())->slots[index];
+}
+
+Value RecordSet::evalRator(const Value &rand1, const Value &rand2) {
+    if (rand1->v_type != V_RECORD || static_cast<Record*>(rand1.get())->type != type) {
+        throw RuntimeError("Record modifier applied to wrong type");
+    }
+    Value &slot = static_cast<Record*>(rand1.get())->slots[index];
+    gcWriteBarrier(slot);
+    slot = rand2;
+    return VoidV();
+}
+
+Value Delay::eval(Assoc &env) { // delay and delay-force
+    return PromiseV(e, env, e_type == E_DELAY_FORCE);
+}
+
+Value MakePromise::evalRator(const Value &rand) { // make-promise
+    if (rand->v_type == V_PROMISE) {
+        return rand;
+    }
+    return ReadyPromiseV(rand);
+}
+
+Value Force::evalRator(const Value &rand) { // force
+    return force(rand);
+}
+
+Value IsPromise::evalRator(const Value &rand) { // promise?
+    return BooleanV(rand->v_type == V_PROMISE);
+}
+
+// Installed exception handlers, innermost last. A null entry marks a guard:
+// raising to it unwinds straight to the guard without calling anything.
+static thread_local std::vector<Value> handler_stack;
+
+namespace {
+struct HandlerInstall {
+    HandlerInstall(const Value &h) { handler_stack.push_back(h); }
+    ~HandlerInstall() { handler_stack.pop_back(); }
+};
+
+// A handler runs with the handlers outside its own installation
+struct HandlerSuspend {
+    Value handler;
+    HandlerSuspend() : handler(handler_stack.back()) { handler_stack.pop_back(); }
+    ~HandlerSuspend() { handler_stack.push_back(handler); }
+};
+
+// An error raised while a handler ran, which only handlers installed at
+// most depth deep may see: the one that ran and those inside it are done
+struct HandledError : RuntimeError {
+    size_t depth;
+    HandledError(const RuntimeError &err, size_t d) : RuntimeError(err), depth(d) {}
+};
+
+// Called with the handler's own installation suspended
+[[noreturn]] void throwHandled(const RuntimeError &err) {
+    size_t depth = handler_stack.size();
+    if (const HandledError *handled = dynamic_cast<const HandledError*>(&err)) {
+        depth = std::min(depth, handled->depth);
+    }
+    throw HandledError(err, depth);
+}
+}
+
+static Value raiseValue(const Value &obj, bool continuable) {
+    if (handler_stack.empty() || handler_stack.back().get() == nullptr) {
+        throw SchemeRaise(obj);
+    }
+    HandlerSuspend suspend;
+    Value result(nullptr);
+    try {
+        result = applyProcedure(suspend.handler, {obj});
+    } catch (const RuntimeError &err) {
+        throwHandled(err);
+    }
+    if (!continuable) {
+        throwHandled(RuntimeError("Exception handler returned from non-continuable raise"));
+    }
+    return result;
+}
+
+Value Raise::evalRator(const Value &rand) { // raise and raise-continuable
+    return raiseValue(rand, continuable);
+}
+
+Value WithHandler::evalRator(const Value &handler, const Value &thunk) { // with-exception-handler
+    if (handler->v_type != V_PROC) {
+        throw RuntimeError("with-exception-handler requires a procedure");
+    }
+    Value error = VoidV();
+    {
+        HandlerInstall install(handler);
+        try {
+            return applyProcedure(thunk, {});
+        } catch (const HandledError &err) {
+            if (err.depth < handler_stack.size()) {
+                throw;
+            }
+            error = ErrorObjectV(err.message(), NullV());
+        } catch (const RuntimeError &err) {
+            // Errors signalled by primitives reach the handler as error objects
+            error = ErrorObjectV(err.message(), NullV());
+        }
+    }
+    applyProcedure(handler, {error});
+    throw RuntimeError("Exception handler returned from non-continuable raise");
+}
+
+Value Guard::eval(Assoc &env) {
+    Value caught = VoidV();
+    try {
+        HandlerInstall install(Value(nullptr));
+        return body->eval(env);
+    } catch (const SchemeRaise &raised) {
+        caught = raised.payload;
+    } catch (const RuntimeError &err) {
+        caught = ErrorObjectV(err.message(), NullV());
+    }
+    Assoc guard_env = extend(var, caught, env);
+    return clauses->eval(guard_env);
+}
+
+Value MakeError::evalRator(const std::vector<Value> &args) { // error
+    if (args.empty() || args[0]->v_type != V_STRING) {
+        throw RuntimeError("error requires a message string");
+    }
+    Value irritants = NullV();
+    for (size_t i = args.size() - 1; i > 0; i--) {
+        irritants = PairV(args[i], irritants);
+    }
+    return raiseValue(ErrorObjectV(dynamic_cast<String*>(args[0].get())->str(), irritants), false);
+}
+
+Value IsError::evalRator(const Value &rand) { // error-object?
+    return BooleanV(rand->v_type == V_ERROR);
+}
+
+Value ErrorMessage::evalRator(const Value &rand) { // error-object-message
+    if (rand->v_type != V_ERROR) {
+        throw RuntimeError("error-object-message requires an error object");
+    }
+    return StringV(dynamic_cast<ErrorObject*>(rand.get())->message);
+}
+
+Value ErrorIrritants::evalRator(const Value &rand) { // error-object-irritants
+    if (rand->v_type != V_ERROR) {
+        throw RuntimeError("error-object-irritants requires an error object");
+    }
+    return dynamic_cast<ErrorObject*>(rand.get())->irritants;
+}
+
+Value FutureFunc::evalRator(const Value &thunk) { // future
+    if (thunk->v_type != V_PROC) {
+        throw RuntimeError("future expects a procedure");
+    }
+    std::shared_ptr<Task> task = std::make_shared<Task>([thunk] { return applyProcedure(thunk, {}); });
+    submitTask(task);
+    return FutureV(task);
+}
+
+Value Touch::evalRator(const Value &rand) { // touch
+    if (rand->v_type != V_FUTURE) {
+        return rand;
+    }
+    std::shared_ptr<Task> task = static_cast<Future*>(rand.get())->task;
+    waitTask(task);
+    return task->values.empty() ? task->result : ValuesV(task->values);
+}
+
+// Run body(i) for every i in [0, n) in chunks spread over the pool
+static void parallelRange(size_t n, const std::function<void(size_t)> &body) {
+    if (n == 0) {
+        return;
+    }
+    size_t chunks = std::min(n, poolSize() * 4);
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (size_t c = 0; c < chunks; c++) {
+        size_t from = n * c / chunks, to = n * (c + 1) / chunks;
+        tasks.push_back(std::make_shared<Task>([from, to, &body] {
+            for (size_t i = from; i < to; i++) {
+                body(i);
+            }
+            return VoidV();
+        }));
+        submitTask(tasks.back());
+    }
+    // Wait for every chunk before rethrowing, since they refer to body
+    std::exception_ptr error;
+    for (auto &task : tasks) {
+        try {
+            waitTask(task);
+        } catch (...) {
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+Value PMap::evalRator(const std::vector<Value> &args) { // pmap
+    if (args.size() < 2) {
+        throw RuntimeError("Wrong number of arguments for pmap");
+    }
+    std::vector<std::vector<Value>> lists(args.size() - 1);
+    size_t n = SIZE_MAX;
+    for (size_t j = 1; j < args.size(); j++) {
+        for (Value p = args[j]; p->v_type == V_PAIR; p = static_cast<Pair*>(p.get())->cdr) {
+            lists[j - 1].push_back(static_cast<Pair*>(p.get())->car);
+        }
+        n = std::min(n, lists[j - 1].size());
+    }
+    Value f = args[0];
+    std::vector<Value> results(n, Value(nullptr));
+    parallelRange(n, [&](size_t i) {
+        std::vector<Value> call_args;
+        for (auto &l : lists) {
+            call_args.push_back(l[i]);
+        }
+        results[i] = applyProcedure(f, call_args);
+    });
+    Value result = NullV();
+    for (size_t i = n; i-- > 0;) {
+        result = PairV(results[i], result);
+    }
+    return result;
+}
+
+Value ParallelFor::evalRator(const std::vector<Value> &args) { // parallel-for
+    if (args[0]->v_type != V_INT || args[1]->v_type != V_INT) {
+        throw RuntimeError("parallel-for expects integer bounds");
+    }
+    int start = static_cast<Integer*>(args[0].get())->n;
+    int end = static_cast<Integer*>(args[1].get())->n;
+    Value f = args[2];
+    if (end > start) {
+        parallelRange((size_t)((long long)end - start), [&](size_t i) {
+            applyProcedure(f, {IntegerV(start + (int)i)});
+        });
+    }
+    return VoidV();
+}
+
+Value Values::evalRator(const std::vector<Value> &args) { // values
+    return ValuesV(args);
+}
+
+Value CallWithValues::evalRator(const Value &producer, const Value &consumer) { // call-with-values
+    std::vector<Value> args;
+    takeValues(applyProcedure(producer, {}), args);
+    return applyProcedure(consumer, args);
+}
+
+Value LetValues::eval(Assoc &env) {
+    Assoc newEnv = env;
+    std::vector<Value> vals;
+    for (size_t i = 0; i < inits.size(); i++) {
+        vals.clear();
+        takeValues(inits[i]->eval(env), vals);
+        const std::vector<std::string> &names = formals[i];
+        if (vals.size() < names.size() || (rests[i].empty() && vals.size() != names.size())) {
+            throw RuntimeError("Wrong number of values");
+        }
+        for (size_t j = 0; j < names.size(); j++) {
+            newEnv = extend(names[j], vals[j], newEnv);
+        }
+        if (!rests[i].empty()) {
+            Value rest = NullV();
+            for (size_t j = vals.size(); j-- > names.size();) {
+                rest = PairV(vals[j], rest);
+            }
+            newEnv = extend(rests[i], rest, newEnv);
+        }
+    }
+    return body->eval(newEnv);
+}
+
 Value Let::eval(Assoc &env) {
     // Create new environment with bindings
     Assoc newEnv = env;
     for (auto& binding : bind) {
-        Value value = binding.second->eval(env);
+        Value value = oneValue(binding.second->eval(env));
         newEnv = extend(binding.first, value, newEnv);
     }
     return body->eval(newEnv);
@@ -749,26 +1747,219 @@ Value Letrec::eval(Assoc &env) {
 
     // Now evaluate the expressions in the new environment
     for (auto& binding : bind) {
-        Value value = binding.second->eval(newEnv);
+        Value value = oneValue(binding.second->eval(newEnv));
         modify(binding.first, value, newEnv);
     }
 
     return body->eval(newEnv);
 }
 
+Value Scope::eval(Assoc &env) {
+    // define inserts behind the head, so an unnamed head keeps it here
+    Assoc local = extend("", VoidV(), env);
+    return body->eval(local);
+}
+
 Value Set::eval(Assoc &env) {
-    Value value = e->eval(env);
+    Value value = oneValue(e->eval(env));
     modify(var, value, env);
     return VoidV();
 }
 
-Value Display::evalRator(const Value &rand) { // display function
-    if (rand->v_type == V_STRING) {
-        String* str_ptr = dynamic_cast<String*>(rand.get());
-        std::cout << str_ptr->s;
+// The port given as argument i, or the console if there is none
+static std::ostream &outputPort(const std::vector<Value> &args, size_t i) {
+    if (args.size() > i + 1) {
+        throw RuntimeError("Too many arguments for an output procedure");
+    }
+    if (args.size() <= i) {
+        return std::cout;
+    }
+    if (args[i]->v_type != V_PORT) {
+        throw RuntimeError("Expected an output port");
+    }
+    return *static_cast<Port*>(args[i].get())->os;
+}
+
+static void writeChars(std::ostream &os, const String *s) {
+    os.write(s->text->chars().data() + s->offset, s->length);
+}
+
+Value Display::evalRator(const std::vector<Value> &args) { // display function
+    if (args.empty()) {
+        throw RuntimeError("Wrong number of arguments for display");
+    }
+    std::ostream &os = outputPort(args, 1);
+    if (args[0]->v_type == V_STRING) {
+        writeChars(os, static_cast<String*>(args[0].get()));
+    } else if (args[0]->v_type == V_CHAR) {
+        os.put(static_cast<Char*>(args[0].get())->c);
     } else {
-        rand->show(std::cout);
+        args[0]->show(os);
+    }
+
+    return VoidV();
+}
+
+Value Write::evalRator(const std::vector<Value> &args) { // write
+    if (args.empty()) {
+        throw RuntimeError("Wrong number of arguments for write");
     }
+    args[0]->show(outputPort(args, 1));
+    return VoidV();
+}
 
+Value WriteString::evalRator(const std::vector<Value> &args) { // write-string
+    if (args.empty()) {
+        throw RuntimeError("Wrong number of arguments for write-string");
+    }
+    std::ostream &os = outputPort(args, 1);
+    writeChars(os, asString(args[0]));
     return VoidV();
 }
+
+Value WriteChar::evalRator(const std::vector<Value> &args) { // write-char
+    if (args.empty()) {
+        throw RuntimeError("Wrong number of arguments for write-char");
+    }
+    std::ostream &os = outputPort(args, 1);
+    os.put(asChar(args[0]));
+    return VoidV();
+}
+
+Value Newline::evalRator(const std::vector<Value> &args) { // newline
+    outputPort(args, 0).put('\n');
+    return VoidV();
+}
+
+Value OpenOutputString::eval(Assoc &e) { // open-output-string
+    return OutputStringPortV();
+}
+
+Value GetOutputString::evalRator(const Value &rand) { // get-output-string
+    if (rand->v_type != V_PORT || !static_cast<Port*>(rand.get())->buffer) {
+        throw RuntimeError("Expected a string port");
+    }
+    return StringV(static_cast<Port*>(rand.get())->buffer->str());
+}
+
+Value CurrentOutputPort::eval(Assoc &e) { // current-output-port
+    return ConsolePortV();
+}
+
+// Read one line from stdin without its terminator; false at end of input
+static bool readLine(std::string &line) {
+    if (!std::getline(std::cin, line)) {
+        return false;
+    }
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
+Value ReadInput::eval(Assoc &e) {
+    switch (e_type) {
+        case E_READ_LINE: { // read-line
+            std::string line;
+            return readLine(line) ? StringV(line) : EofV();
+        }
+        case E_READ_CHAR: { // read-char
+            int c = std::cin.get();
+            return c == EOF ? EofV() : CharV((char)c);
+        }
+        case E_PEEK_CHAR: { // peek-char
+            int c = std::cin.peek();
+            return c == EOF ? EofV() : CharV((char)c);
+        }
+        case E_READ: { // read
+            if (readSpace(std::cin).peek() == EOF) {
+                return EofV();
+            }
+            Syntax stx = readSyntax(std::cin);
+            return syntaxToValue(stx, e);
+        }
+        default: { // stdin-lines
+            static Expr next(new NextLine());
+            return PromiseV(next, empty(), false);
+        }
+    }
+}
+
+Value NextLine::eval(Assoc &e) {
+    std::string line;
+    if (!readLine(line)) {
+        return NullV();
+    }
+    static Expr next(new NextLine());
+    return PairV(StringV(line), PromiseV(next, empty(), false));
+}
+
+Value EofObject::eval(Assoc &e) { // eof-object
+    return EofV();
+}
+
+Value IsEofObject::evalRator(const Value &rand) { // eof-object?
+    return BooleanV(rand->v_type == V_EOF);
+}
+
+static Value alistOf(const std::vector<std::pair<const char *, long>> &fields) {
+    Value result = NullV();
+    for (size_t i = fields.size(); i-- > 0;) {
+        result = PairV(PairV(SymbolV(fields[i].first), IntegerV((int)fields[i].second)), result);
+    }
+    return result;
+}
+
+Value GcControl::eval(Assoc &e) { // gc, gc-stats, heap-stats
+    if (e_type == E_GC) {
+        return IntegerV((int)gcCollect());
+    }
+    std::vector<std::pair<const char *, long>> fields;
+    if (e_type == E_HEAP_STATS) {
+        HeapStats h = heapStats();
+        fields = {
+            {"arenas", (long)h.arenas},
+            {"spare-arenas", (long)h.spare_arenas},
+            {"arena-bytes", (long)h.arena_bytes},
+            {"cell-bytes", (long)h.cell_bytes},
+            {"large-bytes", (long)h.large_bytes},
+            {"arenas-released", (long)h.released},
+            {"limit-bytes", (long)h.limit_bytes},
+            {"out-of-memory", (long)h.failures},
+            {"buffer-bytes", (long)h.buffer_bytes}
+        };
+        return alistOf(fields);
+    }
+    const GcStats &s = gcStats();
+    fields = {
+        {"collections", s.collections},
+        {"freed", (long)s.freed_total},
+        {"last-objects", (long)s.last_objects},
+        {"last-freed", (long)s.last_freed},
+        {"last-slices", s.last_slices},
+        {"last-max-pause-us", s.last_max_pause_us},
+        {"last-total-us", s.last_total_us},
+        {"pause-target-us", s.pause_target_us},
+        {"last-threads", s.last_threads},
+        {"trial-deletions", s.trial_deletions},
+        {"trial-freed", (long)s.trial_freed},
+        {"region-freed", (long)s.region_freed},
+        {"last-over-target", s.last_over_target}
+    };
+    return alistOf(fields);
+}
+
+Value HeapLimit::evalRator(const Value &rand) { // heap-limit!
+    if (rand->v_type != V_INT || dynamic_cast<Integer*>(rand.get())->n < 0) {
+        throw RuntimeError("heap-limit! expects a non-negative integer");
+    }
+    size_t old = heapSetLimit((size_t)dynamic_cast<Integer*>(rand.get())->n << 20);
+    return IntegerV((int)(old >> 20));
+}
+
+Value DumpHeap::evalRator(const Value &rand) { // dump-heap
+    if (rand->v_type != V_STRING) {
+        throw RuntimeError("dump-heap expects a file name");
+    }
+    return IntegerV((int)dumpHeap(static_cast<String*>(rand.get())->str()));
+}
@@ -1,5 +1,6 @@
 #include "Def.hpp"
 #include "expr.hpp"
+#include "value.hpp"
 #include <cstring>
 #include <cstdlib>
 #include <vector>
@@ -41,7 +42,7 @@ RationalNum::RationalNum(int num, int den) : ExprBase(E_RATIONAL), numerator(num
     }
 }
 
-StringExpr::StringExpr(const std::string &str) : ExprBase(E_STRING), s(str) {}
+StringExpr::StringExpr(const std::string &str) : ExprBase(E_STRING), v(immortalize(StringV(str))) {}
 
 True::True() : ExprBase(E_TRUE) {}
 
@@ -117,6 +118,8 @@ SetCar::SetCar(const Expr &r1, const Expr &r2) : Binary(E_SETCAR, r1, r2) {}
 
 SetCdr::SetCdr(const Expr &r1, const Expr &r2) : Binary(E_SETCDR, r1, r2) {}
 
+Append::Append(const std::vector<Expr> &rands) : Variadic(E_APPEND, rands) {}
+
 //LOGIC OPERATIONS
 
 Not::Not(const Expr &r1) : Unary(E_NOT, r1) {}
@@ -145,38 +148,295 @@ IsList::IsList(const Expr &r1) : Unary(E_LISTQ, r1) {}
 
 IsString::IsString(const Expr &r1) : Unary(E_STRINGQ, r1) {}
 
+//STRING OPERATIONS
+
+StringAppend::StringAppend(const std::vector<Expr> &rands) : Variadic(E_STRING_APPEND, rands) {}
+
+Substring::Substring(const std::vector<Expr> &rands) : Variadic(E_SUBSTRING, rands) {}
+
+StringLength::StringLength(const Expr &r1) : Unary(E_STRING_LENGTH, r1) {}
+
+StringRef::StringRef(const Expr &r1, const Expr &r2) : Binary(E_STRING_REF, r1, r2) {}
+
+StringToSymbol::StringToSymbol(const Expr &r1) : Unary(E_STRING_TO_SYMBOL, r1) {}
+
+SymbolToString::SymbolToString(const Expr &r1) : Unary(E_SYMBOL_TO_STRING, r1) {}
+
+NumberToString::NumberToString(const Expr &r1) : Unary(E_NUMBER_TO_STRING, r1) {}
+
+StringToList::StringToList(const Expr &r1) : Unary(E_STRING_TO_LIST, r1) {}
+
+ListToString::ListToString(const Expr &r1) : Unary(E_LIST_TO_STRING, r1) {}
+
+//BYTEVECTORS
+
+MakeBytevector::MakeBytevector(const std::vector<Expr> &rands) : Variadic(E_MAKE_BYTEVECTOR, rands) {}
+
+BytevectorFunc::BytevectorFunc(const std::vector<Expr> &rands) : Variadic(E_BYTEVECTOR, rands) {}
+
+IsBytevector::IsBytevector(const Expr &r1) : Unary(E_BYTEVECTORQ, r1) {}
+
+BytevectorLength::BytevectorLength(const Expr &r1) : Unary(E_BYTEVECTOR_LENGTH, r1) {}
+
+BytevectorRef::BytevectorRef(const Expr &r1, const Expr &r2) : Binary(E_BYTEVECTOR_REF, r1, r2) {}
+
+BytevectorSet::BytevectorSet(const std::vector<Expr> &rands) : Variadic(E_BYTEVECTOR_SET, rands) {}
+
+BytevectorCopy::BytevectorCopy(const std::vector<Expr> &rands) : Variadic(E_BYTEVECTOR_COPY, rands) {}
+
+BytevectorFill::BytevectorFill(const std::vector<Expr> &rands) : Variadic(E_BYTEVECTOR_FILL, rands) {}
+
+//VECTORS
+
+MakeVector::MakeVector(const std::vector<Expr> &rands) : Variadic(E_MAKE_VECTOR, rands) {}
+
+VectorFunc::VectorFunc(const std::vector<Expr> &rands) : Variadic(E_VECTOR, rands) {}
+
+IsVector::IsVector(const Expr &r1) : Unary(E_VECTORQ, r1) {}
+
+VectorLength::VectorLength(const Expr &r1) : Unary(E_VECTOR_LENGTH, r1) {}
+
+VectorRef::VectorRef(const Expr &r1, const Expr &r2) : Binary(E_VECTOR_REF, r1, r2) {}
+
+VectorSet::VectorSet(const std::vector<Expr> &rands) : Variadic(E_VECTOR_SET, rands) {}
+
+VectorToList::VectorToList(const Expr &r1) : Unary(E_VECTOR_TO_LIST, r1) {}
+
+ListToVector::ListToVector(const Expr &r1) : Unary(E_LIST_TO_VECTOR, r1) {}
+
+VectorSum::VectorSum(const Expr &r1) : Unary(E_VECTOR_SUM, r1) {}
+
+VectorDot::VectorDot(const Expr &r1, const Expr &r2) : Binary(E_VECTOR_DOT, r1, r2) {}
+
+VectorMax::VectorMax(const Expr &r1) : Unary(E_VECTOR_MAX, r1) {}
+
+VectorAdd::VectorAdd(const Expr &r1, const Expr &r2) : Binary(E_VECTOR_ADD, r1, r2) {}
+
+VectorMap::VectorMap(const std::vector<Expr> &rands) : Variadic(E_VECTOR_MAP, rands) {}
+
+//HASHTABLES
+
+MakeHashtable::MakeHashtable(ExprType et) : ExprBase(et) {}
+
+IsHashtable::IsHashtable(const Expr &r1) : Unary(E_HASHTABLEQ, r1) {}
+
+HashtableSize::HashtableSize(const Expr &r1) : Unary(E_HASHTABLE_SIZE, r1) {}
+
+HashtableRef::HashtableRef(const std::vector<Expr> &rands) : Variadic(E_HASHTABLE_REF, rands) {}
+
+HashtableSet::HashtableSet(const std::vector<Expr> &rands) : Variadic(E_HASHTABLE_SET, rands) {}
+
+HashtableContains::HashtableContains(const Expr &r1, const Expr &r2) : Binary(E_HASHTABLE_CONTAINS, r1, r2) {}
+
+HashtableDelete::HashtableDelete(const Expr &r1, const Expr &r2) : Binary(E_HASHTABLE_DELETE, r1, r2) {}
+
+HashtableKeys::HashtableKeys(const Expr &r1) : Unary(E_HASHTABLE_KEYS, r1) {}
+
+HashtableClear::HashtableClear(const Expr &r1) : Unary(E_HASHTABLE_CLEAR, r1) {}
+
+//CHARACTERS
+
+IsChar::IsChar(const Expr &r1) : Unary(E_CHARQ, r1) {}
+
+CharToInteger::CharToInteger(const Expr &r1) : Unary(E_CHAR_TO_INTEGER, r1) {}
+
+IntegerToChar::IntegerToChar(const Expr &r1) : Unary(E_INTEGER_TO_CHAR, r1) {}
+
+CharEq::CharEq(const Expr &r1, const Expr &r2) : Binary(E_CHAR_EQ, r1, r2) {}
+
+CharLess::CharLess(const Expr &r1, const Expr &r2) : Binary(E_CHAR_LT, r1, r2) {}
+
 //CONTROL FLOW CONSTRUCTS
 
 Begin::Begin(const vector<Expr> &vec) : ExprBase(E_BEGIN), es(vec) {}
 
 Quote::Quote(const Syntax &t) : ExprBase(E_QUOTE), s(t) {}
 
+Const::Const(const Value &val) : ExprBase(E_QUOTE), v(immortalize(val)) {
+    freezePairs(val);
+}
+
 //CONDITIONAL
 
 If::If(const Expr &c, const Expr &c_t, const Expr &c_e) : ExprBase(E_IF), cond(c), conseq(c_t), alter(c_e) {}
 
 Cond::Cond(const std::vector<std::vector<Expr>> &cls) : ExprBase(E_COND), clauses(cls) {}
 
+Case::Case(const Expr &k) : ExprBase(E_CASE), key(k), else_clause(-1), fix_min(0), null_clause(-1) {
+    bool_clause[0] = bool_clause[1] = -1;
+}
+
+void Case::addFixnum(int n, int clause) {
+    fix_map.insert(std::make_pair(n, clause)); // earlier clauses win
+}
+
+void Case::addSymbol(const std::string &s, int clause) {
+    sym_map.insert(std::make_pair(s, clause));
+}
+
+void Case::addChar(char c, int clause) {
+    if (char_table.empty()) {
+        char_table.assign(256, -1);
+    }
+    int &slot = char_table[(unsigned char)c];
+    if (slot < 0) {
+        slot = clause;
+    }
+}
+
+// Dense fixnum data move from the hash into a directly indexed table
+void Case::buildJumpTable() {
+    if (fix_map.empty()) {
+        return;
+    }
+    long long lo = fix_map.begin()->first, hi = lo;
+    for (auto &entry : fix_map) {
+        if (entry.first < lo) lo = entry.first;
+        if (entry.first > hi) hi = entry.first;
+    }
+    if (hi - lo + 1 > 2 * (long long)fix_map.size() + 16) {
+        return;
+    }
+    fix_min = (int)lo;
+    fix_table.assign(hi - lo + 1, -1);
+    for (auto &entry : fix_map) {
+        fix_table[entry.first - lo] = entry.second;
+    }
+    fix_map.clear();
+}
+
 //VARIABLE AND FUNCITON DEFINITION
 
 Var::Var(const string &s) : ExprBase(E_VAR), x(s) {}
 
 Apply::Apply(const Expr &expr, const vector<Expr> &vec) : ExprBase(E_APPLY), rator(expr), rand(vec) {}
 
-Lambda::Lambda(const vector<string> &vec, const Expr &expr) : ExprBase(E_LAMBDA), x(vec), e(expr) {}
+Lambda::Lambda(const vector<string> &vec, const Expr &expr) : ExprBase(E_LAMBDA), x(vec), rest_used(false), e(expr) {}
+
+Lambda::Lambda(const vector<string> &vec, const string &r, bool used, const Expr &expr)
+    : ExprBase(E_LAMBDA), x(vec), rest(r), rest_used(used), e(expr) {}
+
+CaseLambda::CaseLambda(const vector<Expr> &cs, const vector<int> &arity, int t)
+    : ExprBase(E_CASE_LAMBDA), clauses(cs), by_arity(arity), tail(t) {}
+
+ApplyProc::ApplyProc(const vector<Expr> &rands) : Variadic(E_APPLY_PROC, rands) {}
+
+PrimitiveCall::PrimitiveCall(const string &n) : ExprBase(E_PRIMITIVE_CALL), name(n) {
+    for (auto &slot : fast) {
+        slot.store(nullptr, std::memory_order_relaxed);
+    }
+}
 
 Define::Define(const string &variable, const Expr &expr) : ExprBase(E_DEFINE), var(variable), e(expr) {}
 
+//RECORDS
+
+RecordMake::RecordMake(const std::shared_ptr<RecordType> &t, const vector<int> &sl, const vector<Expr> &rs)
+    : ExprBase(E_RECORD_MAKE), type(t), slot(sl), rands(rs) {}
+
+RecordIs::RecordIs(const std::shared_ptr<RecordType> &t, const Expr &r) : Unary(E_RECORD_IS, r), type(t) {}
+
+RecordRef::RecordRef(const std::shared_ptr<RecordType> &t, int i, const Expr &r)
+    : Unary(E_RECORD_REF, r), type(t), index(i) {}
+
+RecordSet::RecordSet(const std::shared_ptr<RecordType> &t, int i, const Expr &r1, const Expr &r2)
+    : Binary(E_RECORD_SET, r1, r2), type(t), index(i) {}
+
+//PROMISES
+
+Delay::Delay(ExprType et, const Expr &expr) : ExprBase(et), e(expr) {}
+
+MakePromise::MakePromise(const Expr &r) : Unary(E_MAKE_PROMISE, r) {}
+
+Force::Force(const Expr &r) : Unary(E_FORCE, r) {}
+
+IsPromise::IsPromise(const Expr &r) : Unary(E_PROMISEQ, r) {}
+
+//CONTINUATIONS
+
+CallCC::CallCC(const Expr &r) : Unary(E_CALLCC, r) {}
+
+DynamicWind::DynamicWind(const std::vector<Expr> &rands) : Variadic(E_DYNAMIC_WIND, rands) {}
+
+Continue::Continue(const std::shared_ptr<ContinuationState> &t) : ExprBase(E_CONTINUE), target(t) {}
+
+//EXCEPTIONS
+
+Raise::Raise(ExprType et, const Expr &r) : Unary(et, r), continuable(et == E_RAISE_CONTINUABLE) {}
+
+WithHandler::WithHandler(const Expr &r1, const Expr &r2) : Binary(E_WITH_HANDLER, r1, r2) {}
+
+Guard::Guard(const std::string &v, const Expr &b, const Expr &c) : ExprBase(E_GUARD), var(v), body(b), clauses(c) {}
+
+MakeError::MakeError(const std::vector<Expr> &rands) : Variadic(E_ERROR, rands) {}
+
+IsError::IsError(const Expr &r) : Unary(E_ERRORQ, r) {}
+
+ErrorMessage::ErrorMessage(const Expr &r) : Unary(E_ERROR_MESSAGE, r) {}
+
+ErrorIrritants::ErrorIrritants(const Expr &r) : Unary(E_ERROR_IRRITANTS, r) {}
+
+//PARALLELISM
+
+FutureFunc::FutureFunc(const Expr &r1) : Unary(E_FUTURE, r1) {}
+
+Touch::Touch(const Expr &r1) : Unary(E_TOUCH, r1) {}
+
+PMap::PMap(const std::vector<Expr> &rands) : Variadic(E_PMAP, rands) {}
+
+ParallelFor::ParallelFor(const std::vector<Expr> &rands) : Variadic(E_PARALLEL_FOR, rands) {}
+
+//MULTIPLE VALUES
+
+Values::Values(const std::vector<Expr> &rands) : Variadic(E_VALUES, rands) {}
+
+CallWithValues::CallWithValues(const Expr &r1, const Expr &r2) : Binary(E_CALL_WITH_VALUES, r1, r2) {}
+
+LetValues::LetValues(const vector<vector<string>> &fs, const vector<string> &rs, const vector<Expr> &is, const Expr &b)
+    : ExprBase(E_LET_VALUES), formals(fs), rests(rs), inits(is), body(b) {}
+
 //BINDING CONSTRUCTS
 
 Let::Let(const vector<pair<string, Expr>> &vec, const Expr &e) : ExprBase(E_LET), bind(vec), body(e) {}
 
 Letrec::Letrec(const vector<pair<string, Expr>> &vec, const Expr &expr) : ExprBase(E_LETREC), bind(vec), body(expr) {}
 
+Scope::Scope(const Expr &expr) : ExprBase(E_SCOPE), body(expr) {}
+
 //ASSIGNMENT
 
 Set::Set(const std::string &var, const Expr &e) : ExprBase(E_SET), var(var), e(e) {}
 
 //I/O OPERATIONS
 
-Display::Display(const Expr &r) : Unary(E_DISPLAY, r) {}
\ No newline at end of file
+Display::Display(const std::vector<Expr> &rands) : Variadic(E_DISPLAY, rands) {}
+
+Write::Write(const std::vector<Expr> &rands) : Variadic(E_WRITE, rands) {}
+
+WriteString::WriteString(const std::vector<Expr> &rands) : Variadic(E_WRITE_STRING, rands) {}
+
+WriteChar::WriteChar(const std::vector<Expr> &rands) : Variadic(E_WRITE_CHAR, rands) {}
+
+Newline::Newline(const std::vector<Expr> &rands) : Variadic(E_NEWLINE, rands) {}
+
+OpenOutputString::OpenOutputString() : ExprBase(E_OPEN_OUTPUT_STRING) {}
+
+GetOutputString::GetOutputString(const Expr &r) : Unary(E_GET_OUTPUT_STRING, r) {}
+
+CurrentOutputPort::CurrentOutputPort() : ExprBase(E_CURRENT_OUTPUT_PORT) {}
+
+ReadInput::ReadInput(ExprType et) : ExprBase(et) {}
+
+NextLine::NextLine() : ExprBase(E_NEXT_LINE) {}
+
+EofObject::EofObject() : ExprBase(E_EOF_OBJECT) {}
+
+IsEofObject::IsEofObject(const Expr &r) : Unary(E_EOF_OBJECTQ, r) {}
+
+//MEMORY
+
+GcControl::GcControl(ExprType et) : ExprBase(et) {}
+
+HeapLimit::HeapLimit(const Expr &r) : Unary(E_HEAP_LIMIT, r) {}
+
+DumpHeap::DumpHeap(const Expr &r) : Unary(E_DUMP_HEAP, r) {}
\ No newline at end of file
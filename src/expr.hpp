@@ -20,8 +20,12 @@ public:
 #include "Def.hpp"
 #include "syntax.hpp"
 #include <memory>
+#include <atomic>
 #include <cstring>
 #include <vector>
+#include <map>
+#include <mutex>
+#include <unordered_map>
 
 struct ExprBase{
     ExprType e_type;
@@ -69,7 +73,7 @@ struct RationalNum : ExprBase {
  * Represents string values
  */
 struct StringExpr : ExprBase {
-  std::string s;
+  ValueBase *v;   ///< Strings are immutable, so one immortal value serves every evaluation
   StringExpr(const std::string &);
   virtual Value eval(Assoc &) override;
 };
@@ -268,6 +272,11 @@ struct SetCdr : Binary {
     virtual Value evalRator(const Value &, const Value &) override;
 };
 
+struct Append : Variadic {
+    Append(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
 // ================================================================================
 //                             LOGIC OPERATIONS
 // ================================================================================
@@ -338,6 +347,269 @@ struct IsString : Unary {
     virtual Value evalRator(const Value &) override;
 };
 
+// ================================================================================
+//                             STRING OPERATIONS
+// ================================================================================
+
+struct StringAppend : Variadic {
+    StringAppend(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct Substring : Variadic {
+    Substring(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct StringLength : Unary {
+    StringLength(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct StringRef : Binary {
+    StringRef(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+struct StringToSymbol : Unary {
+    StringToSymbol(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct SymbolToString : Unary {
+    SymbolToString(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct NumberToString : Unary {
+    NumberToString(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct StringToList : Unary {
+    StringToList(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct ListToString : Unary {
+    ListToString(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+// ================================================================================
+//                             BYTEVECTORS
+// ================================================================================
+
+struct MakeBytevector : Variadic {
+    MakeBytevector(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct BytevectorFunc : Variadic {
+    BytevectorFunc(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct IsBytevector : Unary {
+    IsBytevector(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct BytevectorLength : Unary {
+    BytevectorLength(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct BytevectorRef : Binary {
+    BytevectorRef(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+struct BytevectorSet : Variadic {
+    BytevectorSet(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+/**
+ * @brief (bytevector-copy! to at from [start [end]]), one memmove
+ */
+struct BytevectorCopy : Variadic {
+    BytevectorCopy(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+/**
+ * @brief (bytevector-fill! bv byte [start [end]]), one memset
+ */
+struct BytevectorFill : Variadic {
+    BytevectorFill(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+// ================================================================================
+//                             VECTORS
+// ================================================================================
+
+struct MakeVector : Variadic {
+    MakeVector(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct VectorFunc : Variadic {
+    VectorFunc(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct IsVector : Unary {
+    IsVector(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct VectorLength : Unary {
+    VectorLength(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct VectorRef : Binary {
+    VectorRef(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+struct VectorSet : Variadic {
+    VectorSet(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct VectorToList : Unary {
+    VectorToList(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct ListToVector : Unary {
+    ListToVector(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+// The bulk numeric primitives below take packed fixnum vectors
+
+struct VectorSum : Unary {
+    VectorSum(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct VectorDot : Binary {
+    VectorDot(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+struct VectorMax : Unary {
+    VectorMax(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct VectorAdd : Binary {
+    VectorAdd(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+/**
+ * @brief (vector-map f v ...)
+ * +, - or * over two packed vectors runs as one kernel; anything else
+ * applies f element by element.
+ */
+struct VectorMap : Variadic {
+    VectorMap(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+// ================================================================================
+//                             HASHTABLES
+// ================================================================================
+
+/**
+ * @brief (make-eq-hashtable) and (make-weak-eq-hashtable)
+ * Keys compare with eq?; the weak table does not keep its keys alive.
+ */
+struct MakeHashtable : ExprBase {
+    MakeHashtable(ExprType);
+    virtual Value eval(Assoc &) override;
+};
+
+struct IsHashtable : Unary {
+    IsHashtable(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct HashtableSize : Unary {
+    HashtableSize(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+/**
+ * @brief (hashtable-ref table key default)
+ */
+struct HashtableRef : Variadic {
+    HashtableRef(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct HashtableSet : Variadic {
+    HashtableSet(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct HashtableContains : Binary {
+    HashtableContains(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+struct HashtableDelete : Binary {
+    HashtableDelete(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+/**
+ * @brief (hashtable-keys table), a vector in no particular order
+ */
+struct HashtableKeys : Unary {
+    HashtableKeys(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct HashtableClear : Unary {
+    HashtableClear(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+// ================================================================================
+//                             CHARACTERS
+// ================================================================================
+
+struct IsChar : Unary {
+    IsChar(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct CharToInteger : Unary {
+    CharToInteger(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct IntegerToChar : Unary {
+    IntegerToChar(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct CharEq : Binary {
+    CharEq(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+struct CharLess : Binary {
+    CharLess(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
 // ================================================================================
 //                             CONTROL FLOW CONSTRUCTS
 // ================================================================================
@@ -354,6 +626,18 @@ struct Quote : ExprBase {
   virtual Value eval(Assoc &) override;
 };
 
+/**
+ * @brief A constant built once at parse time
+ * Used for the constant parts of quasiquote templates, which every
+ * evaluation shares instead of rebuilding. Its pairs are immutable, so no
+ * evaluation can change what the next one sees.
+ */
+struct Const : ExprBase {
+  ValueBase *v;   ///< Immortal, so evaluations on any thread share it uncounted
+  Const(const Value &);
+  virtual Value eval(Assoc &) override;
+};
+
 // ================================================================================
 //                             CONDITIONALS
 // ================================================================================
@@ -372,6 +656,30 @@ struct Cond : ExprBase {
     virtual Value eval(Assoc &) override;
 };
 
+/**
+ * @brief case dispatch resolved at parse time
+ * Fixnum data index a jump table (or a hash when sparse), symbols hash on
+ * their name; a lookup yields the clause to run, or -1 for none.
+ */
+struct Case : ExprBase {
+    Expr key;
+    std::vector<Expr> bodies;
+    int else_clause;
+    int fix_min;
+    std::vector<int> fix_table;
+    std::unordered_map<int, int> fix_map;
+    std::unordered_map<std::string, int> sym_map;
+    std::vector<int> char_table;                 ///< Indexed by character, empty if no character data
+    int bool_clause[2];
+    int null_clause;
+    Case(const Expr &);
+    void addFixnum(int, int);
+    void addSymbol(const std::string &, int);
+    void addChar(char, int);
+    void buildJumpTable();
+    virtual Value eval(Assoc &) override;
+};
+
 // ================================================================================
 //                             VARIABLE AND FUNCITION DEFINITION
 // ================================================================================
@@ -391,8 +699,53 @@ struct Apply : ExprBase {
 
 struct Lambda : ExprBase {
     std::vector<std::string> x;
+    std::string rest;
+    bool rest_used;
     Expr e;
     Lambda(const std::vector<std::string> &, const Expr &);
+    Lambda(const std::vector<std::string> &, const std::string &, bool, const Expr &);
+    virtual Value eval(Assoc &) override;
+};
+
+/**
+ * @brief case-lambda
+ * The clause for each argument count is worked out at parse time, so a call
+ * picks its clause with one index.
+ */
+struct CaseLambda : ExprBase {
+    std::vector<Expr> clauses;
+    std::vector<int> by_arity;
+    int tail;
+    CaseLambda(const std::vector<Expr> &, const std::vector<int> &, int);
+    virtual Value eval(Assoc &) override;
+};
+
+struct ApplyProc : Variadic {
+    ApplyProc(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+/**
+ * @brief Body of a primitive used as a value, e.g. (apply + xs)
+ * The call for each argument count is parsed once and cached; a call that
+ * parses to a Unary, Binary or Variadic primitive is handed the argument
+ * vector directly, anything else is evaluated in a frame binding %0 %1 ...
+ */
+struct PrimitiveCall : ExprBase {
+    struct Form {
+        enum Kind {FRAME, UNARY, BINARY, VARIADIC} kind;
+        Expr body;
+        std::vector<std::string> names;  ///< %0 %1 ... for the FRAME case
+        Form(Kind k, const Expr &b, const std::vector<std::string> &n) : kind(k), body(b), names(n) {}
+    };
+    static const size_t FAST_ARITIES = 8;
+    std::string name;
+    std::atomic<Form*> fast[FAST_ARITIES];   ///< Lock-free view of by_arity for small counts
+    std::map<size_t, Form> by_arity;
+    std::mutex cache_lock;               ///< Guards by_arity; only taken to parse a new count
+    PrimitiveCall(const std::string &);
+    const Form &form(size_t);
+    Value call(const std::vector<Value> &);
     virtual Value eval(Assoc &) override;
 };
 
@@ -403,6 +756,197 @@ struct Define : ExprBase {
     virtual Value eval(Assoc &) override;
 };
 
+// ================================================================================
+//                             RECORDS
+// ================================================================================
+
+/**
+ * @brief Bodies of the procedures define-record-type generates
+ * Each checks the record's type with one descriptor compare and then
+ * indexes the slot directly.
+ */
+struct RecordMake : ExprBase {
+    std::shared_ptr<RecordType> type;
+    std::vector<int> slot;      ///< Slot filled by each argument
+    std::vector<Expr> rands;
+    RecordMake(const std::shared_ptr<RecordType> &, const std::vector<int> &, const std::vector<Expr> &);
+    virtual Value eval(Assoc &) override;
+};
+
+struct RecordIs : Unary {
+    std::shared_ptr<RecordType> type;
+    RecordIs(const std::shared_ptr<RecordType> &, const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct RecordRef : Unary {
+    std::shared_ptr<RecordType> type;
+    int index;
+    RecordRef(const std::shared_ptr<RecordType> &, int, const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct RecordSet : Binary {
+    std::shared_ptr<RecordType> type;
+    int index;
+    RecordSet(const std::shared_ptr<RecordType> &, int, const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+// ================================================================================
+//                             PROMISES
+// ================================================================================
+
+struct Delay : ExprBase {
+    Expr e;
+    Delay(ExprType, const Expr &);
+    virtual Value eval(Assoc &) override;
+};
+
+struct MakePromise : Unary {
+    MakePromise(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct Force : Unary {
+    Force(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct IsPromise : Unary {
+    IsPromise(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+// ================================================================================
+//                             CONTINUATIONS
+// ================================================================================
+
+struct CallCC : Unary {
+    CallCC(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct DynamicWind : Variadic {
+    DynamicWind(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+/**
+ * @brief Body of a continuation procedure: escape to its call/cc
+ */
+struct Continue : ExprBase {
+    std::shared_ptr<ContinuationState> target;
+    Continue(const std::shared_ptr<ContinuationState> &);
+    virtual Value eval(Assoc &) override;
+};
+
+// ================================================================================
+//                             EXCEPTIONS
+// ================================================================================
+
+struct Raise : Unary {
+    bool continuable;
+    Raise(ExprType, const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct WithHandler : Binary {
+    WithHandler(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+/**
+ * @brief (guard (var clause ...) body ...)
+ * clauses is a Cond over var that re-raises when no clause applies.
+ */
+struct Guard : ExprBase {
+    std::string var;
+    Expr body;
+    Expr clauses;
+    Guard(const std::string &, const Expr &, const Expr &);
+    virtual Value eval(Assoc &) override;
+};
+
+struct MakeError : Variadic {
+    MakeError(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct IsError : Unary {
+    IsError(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct ErrorMessage : Unary {
+    ErrorMessage(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct ErrorIrritants : Unary {
+    ErrorIrritants(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+// ================================================================================
+//                             PARALLELISM
+// ================================================================================
+
+struct FutureFunc : Unary {
+    FutureFunc(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct Touch : Unary {
+    Touch(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+/**
+ * @brief (pmap f list ...), map with the calls spread over the pool
+ */
+struct PMap : Variadic {
+    PMap(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+/**
+ * @brief (parallel-for start end proc) calls (proc i) for start <= i < end
+ */
+struct ParallelFor : Variadic {
+    ParallelFor(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+// ================================================================================
+//                             MULTIPLE VALUES
+// ================================================================================
+
+struct Values : Variadic {
+    Values(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct CallWithValues : Binary {
+    CallWithValues(const Expr &, const Expr &);
+    virtual Value evalRator(const Value &, const Value &) override;
+};
+
+/**
+ * @brief let-values and receive
+ * Each formals list names the values of its expression; a non-empty rest
+ * name collects the remaining values as a list.
+ */
+struct LetValues : ExprBase {
+    std::vector<std::vector<std::string>> formals;
+    std::vector<std::string> rests;
+    std::vector<Expr> inits;
+    Expr body;
+    LetValues(const std::vector<std::vector<std::string>> &, const std::vector<std::string> &,
+              const std::vector<Expr> &, const Expr &);
+    virtual Value eval(Assoc &) override;
+};
+
 // ================================================================================
 //                             BINDING CONSTRUCTS
 // ================================================================================
@@ -421,6 +965,17 @@ struct Letrec : ExprBase {
     virtual Value eval(Assoc &) override;
 };
 
+/**
+ * @brief A body that gets a frame of its own for its internal defines
+ * Wraps procedure and let bodies that would otherwise run in the
+ * environment they were created in, which they must not add to.
+ */
+struct Scope : ExprBase {
+    Expr body;
+    Scope(const Expr &);
+    virtual Value eval(Assoc &) override;
+};
+
 // ================================================================================
 //                             ASSIGNMENT
 // ================================================================================
@@ -436,8 +991,104 @@ struct Set : ExprBase {
 //                              I/O OPERATIONS
 // ================================================================================
 
-struct Display : Unary {
-    Display(const Expr &);
+// Output procedures take the port as an optional last argument
+
+struct Display : Variadic {
+    Display(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct Write : Variadic {
+    Write(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct WriteString : Variadic {
+    WriteString(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct WriteChar : Variadic {
+    WriteChar(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct Newline : Variadic {
+    Newline(const std::vector<Expr> &);
+    virtual Value evalRator(const std::vector<Value> &) override;
+};
+
+struct OpenOutputString : ExprBase {
+    OpenOutputString();
+    virtual Value eval(Assoc &) override;
+};
+
+struct GetOutputString : Unary {
+    GetOutputString(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+struct CurrentOutputPort : ExprBase {
+    CurrentOutputPort();
+    virtual Value eval(Assoc &) override;
+};
+
+/**
+ * @brief Input from stdin
+ * These read from std::cin, the stream the REPL reads program text from, so
+ * data may follow the form that reads it.
+ */
+struct ReadInput : ExprBase {
+    ReadInput(ExprType);
+    virtual Value eval(Assoc &) override;
+};
+
+/**
+ * @brief Body of each promise in the stdin-lines stream
+ * Reads one line when forced and yields (line . next-promise), or () at end
+ * of input.
+ */
+struct NextLine : ExprBase {
+    NextLine();
+    virtual Value eval(Assoc &) override;
+};
+
+struct EofObject : ExprBase {
+    EofObject();
+    virtual Value eval(Assoc &) override;
+};
+
+struct IsEofObject : Unary {
+    IsEofObject(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+/**
+ * @brief (gc), (gc-stats) and (heap-stats)
+ * (gc) runs a whole cycle collection and yields how many containers it
+ * freed; (gc-stats) yields an association list about the collections and
+ * (heap-stats) one about the arenas values live in.
+ */
+struct GcControl : ExprBase {
+    GcControl(ExprType);
+    virtual Value eval(Assoc &) override;
+};
+
+/**
+ * @brief (heap-limit! mib) caps the heap at mib MiB, 0 for no cap
+ * Yields the previous cap in MiB.
+ */
+struct HeapLimit : Unary {
+    HeapLimit(const Expr &);
+    virtual Value evalRator(const Value &) override;
+};
+
+/**
+ * @brief (dump-heap "file") writes a heap snapshot (see dump.hpp)
+ * Yields how many values it lists; an error while futures are running.
+ */
+struct DumpHeap : Unary {
+    DumpHeap(const Expr &);
     virtual Value evalRator(const Value &) override;
 };
 
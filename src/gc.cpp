@@ -0,0 +1,773 @@
+/**
+ * @file gc.cpp
+ * @brief Slot table, phases and pacing of the cycle collector
+ *
+ * The collector state belongs to the main thread. Slices only run while no
+ * pool task is in flight, so apart from the slot table itself (which pool
+ * threads also register containers in) nothing here is shared. The one
+ * exception is a cycle run to completion on a large heap: the pool's threads
+ * then share out each pass, the scans a chunk of slots at a time and the mark
+ * through per-thread stacks they steal from each other.
+ */
+
+#include "gc.hpp"
+#include "dump.hpp"
+#include "pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+std::atomic<bool> gc_barrier_on(false);
+bool gc_trial_deletion = false;
+
+namespace {
+
+enum Phase {
+    IDLE,
+    COUNT,      ///< Snapshot counts, turning survivors white
+    SUBTRACT,   ///< Take out the references white containers hold to each other
+    ROOTS,      ///< Shade whatever is still referenced from outside
+    MARK,       ///< Scan grey containers until none are left
+    CLEAR,      ///< Drop the references held by white (garbage) containers
+    FREE        ///< Delete them
+};
+
+const uint32_t CHUNK_BITS = 12;
+const uint32_t CHUNK = 1u << CHUNK_BITS;
+const long MIN_TRIGGER = 1 << 18;   ///< Containers allocated before the first cycle
+const long SLICE_EVERY = 4096;      ///< Containers allocated between slices
+const uint32_t PARALLEL_MIN = 16 * CHUNK;   ///< Slots before whole cycles use the pool
+const size_t MIN_CANDIDATES = 1 << 14;      ///< Possible roots buffered before the first trial deletion
+
+/**
+ * @brief Every tracked container, by slot
+ * Chunks never move, so a slot stays put while the table grows. Allocated
+ * once and never freed, since containers held by static objects untrack
+ * during exit.
+ */
+struct SlotTable {
+    std::mutex lock;
+    std::vector<std::unique_ptr<std::atomic<ValueBase *>[]>> chunks;
+    std::vector<uint32_t> free_slots;
+    uint32_t end = 0;
+    size_t live = 0;
+
+    std::atomic<ValueBase *> &at(uint32_t i) {
+        return chunks[i >> CHUNK_BITS][i & (CHUNK - 1)];
+    }
+
+    ValueBase *get(uint32_t i) {
+        return at(i).load(std::memory_order_relaxed);
+    }
+};
+
+SlotTable &table() {
+    static SlotTable *t = new SlotTable();
+    return *t;
+}
+
+std::atomic<int> phase(IDLE);
+std::atomic<long> allocated(0);        ///< Containers tracked since the last cycle
+std::atomic<long> work_due(MIN_TRIGGER);
+long trigger = MIN_TRIGGER;
+uint32_t cursor = 0;
+bool in_slice = false;
+std::vector<uint32_t> grey;            ///< Slots of shaded containers; stale entries are skipped
+std::vector<uint32_t> candidates;      ///< Slots of purple containers; stale entries are skipped
+bool regions = false;
+std::vector<uint32_t> region;          ///< Slots allocated since the last region reset, under the table lock
+size_t candidate_limit = MIN_CANDIDATES;
+
+// While the pool clears garbage, containers it releases to zero wait here
+bool deferring = false;
+std::mutex deferred_lock;
+std::vector<ValueBase *> deferred;
+
+GcStats stats = {0, 0, 0, 0, 0, 0, 0, 0, 1000, 1, 0, 0, 0};
+bool log_cycles = false;
+
+struct Settings {
+    Settings() {
+        if (const char *env = std::getenv("SCHEME_GC_PAUSE_US")) {
+            stats.pause_target_us = std::max(0L, std::atol(env));
+        }
+        if (const char *env = std::getenv("SCHEME_GC_TRIAL")) {
+            gc_trial_deletion = env[0] != '\0' && env[0] != '0';
+        }
+        if (const char *env = std::getenv("SCHEME_GC_REGIONS")) {
+            regions = env[0] != '\0' && env[0] != '0';
+        }
+        if (const char *env = std::getenv("SCHEME_GC_LOG")) {
+            log_cycles = env[0] != '\0' && env[0] != '0';
+        }
+    }
+} settings;
+
+struct ShadeVisitor : GcVisitor {
+    ShadeVisitor() : GcVisitor(false) {}
+    virtual void visit(ValueBase *p) override {
+        gcShade(p);
+    }
+};
+
+struct SubtractVisitor : GcVisitor {
+    SubtractVisitor() : GcVisitor(true) {}
+    virtual void visit(ValueBase *p) override {
+        if (p->gc_color.load(std::memory_order_relaxed) == GC_WHITE) {
+            p->gc_refs.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+void startCycle() {
+    pauseBiasedMerges(true);
+    phase = COUNT;
+    gc_barrier_on = true;
+    cursor = 0;
+    stats.last_objects = 0;
+    stats.last_freed = 0;
+    stats.last_slices = 0;
+    stats.last_max_pause_us = 0;
+    stats.last_over_target = 0;
+    stats.last_total_us = 0;
+    stats.last_threads = 1;
+}
+
+void endCycle() {
+    phase = IDLE;
+    pauseBiasedMerges(false);
+    {
+        std::lock_guard<std::mutex> lock(table().lock);
+        trigger = std::max(2 * (long)table().live, MIN_TRIGGER);
+    }
+    allocated = 0;
+}
+
+void reportCycle() {
+    stats.collections++;
+    stats.freed_total += stats.last_freed;
+    if (log_cycles) {
+        std::fprintf(stderr, "[gc %ld] %zu containers, %zu freed, %ld slices (%ld over target), max pause %ld us, "
+                     "total %ld us, %ld threads\n",
+                     stats.collections, stats.last_objects, stats.last_freed, stats.last_slices,
+                     stats.last_over_target, stats.last_max_pause_us, stats.last_total_us, stats.last_threads);
+    }
+}
+
+/**
+ * @brief A pool thread's share of the grey containers
+ * The owner pushes and pops at the back; thieves take the older half.
+ */
+struct MarkStack {
+    std::mutex m;
+    std::vector<ValueBase *> items;
+
+    void push(ValueBase *p) {
+        std::lock_guard<std::mutex> lock(m);
+        items.push_back(p);
+    }
+};
+
+// Shading by the pool: containers go on the shading thread's own stack
+struct StackShadeVisitor : GcVisitor {
+    MarkStack &own;
+    StackShadeVisitor(MarkStack &own) : GcVisitor(false), own(own) {}
+    virtual void visit(ValueBase *p) override {
+        uint8_t white = GC_WHITE;
+        if (p->gc_color.compare_exchange_strong(white, GC_GREY, std::memory_order_relaxed)) {
+            own.push(p);
+        }
+    }
+};
+
+struct ScanState {
+    size_t objects = 0;
+    size_t freed = 0;
+    MarkStack *shaded = nullptr;   ///< Where roots go; the grey list when null
+};
+
+// The per-container step of every phase but MARK
+void scan(ValueBase *p, int ph, ScanState &s) {
+    uint8_t color = p->gc_color.load(std::memory_order_relaxed);
+    switch (ph) {
+        case COUNT:
+            if (color == GC_BLACK || color == GC_PURPLE) {
+                p->gc_color = GC_WHITE;
+                p->gc_refs.store(referenceCount(p), std::memory_order_relaxed);
+                s.objects++;
+            }
+            break;
+        case SUBTRACT:
+            if (color == GC_WHITE) {
+                SubtractVisitor subtract;
+                p->traverse(subtract);
+            }
+            break;
+        case ROOTS:
+            if (color == GC_WHITE && p->gc_refs.load(std::memory_order_relaxed) > 0) {
+                if (s.shaded != nullptr) {
+                    StackShadeVisitor(*s.shaded).visit(p);
+                } else {
+                    gcShade(p);
+                }
+            }
+            break;
+        case CLEAR:
+            if (color == GC_WHITE) {
+                p->clearRefs();
+                s.freed++;
+            } else if (color == GC_NEW) {
+                p->gc_color = GC_BLACK;
+            }
+            break;
+        case FREE:
+            if (color == GC_WHITE) {
+                delete p;
+            }
+            break;
+    }
+}
+
+// One unit of work; false when the phase is finished
+bool workUnit() {
+    SlotTable &t = table();
+    if (phase == MARK) {
+        if (grey.empty()) {
+            gc_barrier_on = false;
+            phase = CLEAR;
+            cursor = 0;
+            return false;
+        }
+        uint32_t slot = grey.back();
+        grey.pop_back();
+        ValueBase *p = slot < t.end ? t.get(slot) : nullptr;
+        if (p != nullptr && p->gc_color.load(std::memory_order_relaxed) == GC_GREY) {
+            p->gc_color = GC_BLACK;
+            ShadeVisitor shade;
+            p->traverse(shade);
+        }
+        return true;
+    }
+    if (cursor >= t.end) {
+        cursor = 0;
+        switch (phase.load()) {
+            case COUNT: phase = SUBTRACT; break;
+            case SUBTRACT: phase = ROOTS; break;
+            case ROOTS: phase = MARK; break;
+            case CLEAR:
+                // Garbage released by other threads' containers waits in their
+                // merge queues; settle it here so nothing queued gets freed
+                mergeAllBiasedCounts();
+                phase = FREE;
+                break;
+            default: endCycle(); break;
+        }
+        return false;
+    }
+    ValueBase *p = t.get(cursor++);
+    if (p != nullptr) {
+        ScanState s;
+        scan(p, phase, s);
+        stats.last_objects += s.objects;
+        stats.last_freed += s.freed;
+    }
+    return true;
+}
+
+// Pop from our own stack, else steal the older half of another's
+bool takeGrey(MarkStack *stacks, size_t n, size_t i, ValueBase *&p) {
+    {
+        std::lock_guard<std::mutex> lock(stacks[i].m);
+        if (!stacks[i].items.empty()) {
+            p = stacks[i].items.back();
+            stacks[i].items.pop_back();
+            return true;
+        }
+    }
+    for (size_t k = 1; k < n; k++) {
+        MarkStack &victim = stacks[(i + k) % n];
+        std::vector<ValueBase *> loot;
+        {
+            std::lock_guard<std::mutex> lock(victim.m);
+            size_t take = (victim.items.size() + 1) / 2;
+            loot.assign(victim.items.begin(), victim.items.begin() + take);
+            victim.items.erase(victim.items.begin(), victim.items.begin() + take);
+        }
+        if (!loot.empty()) {
+            p = loot.back();
+            loot.pop_back();
+            std::lock_guard<std::mutex> lock(stacks[i].m);
+            stacks[i].items.insert(stacks[i].items.end(), loot.begin(), loot.end());
+            return true;
+        }
+    }
+    return false;
+}
+
+bool anyGrey(MarkStack *stacks, size_t n) {
+    for (size_t k = 0; k < n; k++) {
+        std::lock_guard<std::mutex> lock(stacks[k].m);
+        if (!stacks[k].items.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Pool thread i's part of the mark
+ * A thread counts as active while it may still push; the mark is over once
+ * no thread is active and every stack is empty.
+ */
+void markShare(MarkStack *stacks, size_t n, size_t i, std::atomic<size_t> &active) {
+    StackShadeVisitor shade(stacks[i]);
+    active++;
+    while (true) {
+        ValueBase *p;
+        if (takeGrey(stacks, n, i, p)) {
+            p->gc_color.store(GC_BLACK, std::memory_order_relaxed);
+            p->traverse(shade);
+            continue;
+        }
+        active--;
+        while (!anyGrey(stacks, n)) {
+            if (active.load() == 0) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+        active++;
+    }
+}
+
+// Pool thread i's part of a scan: whole chunks from the cursor on
+void scanShare(int ph, size_t i, std::atomic<uint32_t> &next_chunk, MarkStack *stacks, ScanState *states) {
+    SlotTable &t = table();
+    ScanState &s = states[i];
+    s.shaded = &stacks[i];
+    while (true) {
+        uint32_t c = next_chunk++;
+        uint32_t from = std::max(c << CHUNK_BITS, cursor);
+        if (c >= t.chunks.size() || from >= t.end) {
+            return;
+        }
+        uint32_t to = std::min((c + 1) << CHUNK_BITS, t.end);
+        for (uint32_t slot = from; slot < to; slot++) {
+            if (ValueBase *p = t.get(slot)) {
+                scan(p, ph, s);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Run the rest of the cycle on n pool threads
+ * Nothing else runs meanwhile, so until the clear no count changes and no
+ * container dies. Clearing does release counts, as does freeing a weak
+ * hashtable key (its entry goes); a container outside the garbage that goes
+ * with either is only deleted once every thread is done.
+ */
+void finishOnPool(size_t n) {
+    SlotTable &t = table();
+    std::unique_ptr<MarkStack[]> stacks(new MarkStack[n]);
+    stats.last_threads = (long)n;
+    while (phase != IDLE) {
+        int ph = phase;
+        if (ph == MARK) {
+            for (uint32_t slot : grey) {
+                ValueBase *p = slot < t.end ? t.get(slot) : nullptr;
+                if (p != nullptr && p->gc_color.load(std::memory_order_relaxed) == GC_GREY) {
+                    stacks[0].items.push_back(p);
+                }
+            }
+            grey.clear();
+            std::atomic<size_t> active(0);
+            parallelInvoke(n, [&](size_t i) { markShare(stacks.get(), n, i, active); });
+        } else {
+            std::unique_ptr<ScanState[]> states(new ScanState[n]);
+            std::atomic<uint32_t> next_chunk(cursor >> CHUNK_BITS);
+            deferring = ph == CLEAR || ph == FREE;
+            parallelInvoke(n, [&](size_t i) { scanShare(ph, i, next_chunk, stacks.get(), states.get()); });
+            deferring = false;
+            for (size_t i = 0; i < n; i++) {
+                stats.last_objects += states[i].objects;
+                stats.last_freed += states[i].freed;
+            }
+            std::vector<ValueBase *> dead;
+            dead.swap(deferred);
+            for (ValueBase *p : dead) {
+                delete p;
+            }
+            cursor = t.end;
+        }
+        // Moves on to the next phase
+        workUnit();
+    }
+}
+
+// Threads for running the rest of a cycle in one go
+size_t cycleThreads() {
+    return table().end < PARALLEL_MIN ? 1 : poolSize();
+}
+
+// Work until the cycle ends or the budget runs out; budget < 0 means no limit
+void slice(long budget_us) {
+    typedef std::chrono::steady_clock Clock;
+    in_slice = true;
+    Clock::time_point start = Clock::now();
+    size_t n = budget_us < 0 ? cycleThreads() : 1;
+    if (n > 1) {
+        finishOnPool(n);
+    }
+    // A unit can be one container or a whole vector's references, so the
+    // clock is read after every one rather than after a fixed count
+    Clock::time_point deadline = start + std::chrono::microseconds(budget_us);
+    while (phase != IDLE) {
+        workUnit();
+        if (budget_us >= 0 && Clock::now() >= deadline) {
+            break;
+        }
+    }
+    long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+    in_slice = false;
+    stats.last_slices++;
+    stats.last_total_us += elapsed;
+    stats.last_max_pause_us = std::max(stats.last_max_pause_us, elapsed);
+    if (budget_us >= 0 && elapsed > budget_us) {
+        stats.last_over_target++;
+    }
+    if (phase == IDLE) {
+        reportCycle();
+    }
+}
+
+// Trial deletion: count every reference the subgraph holds to itself
+struct TrialVisitor : GcVisitor {
+    std::vector<ValueBase *> &reached;
+    std::vector<ValueBase *> &pending;
+    TrialVisitor(std::vector<ValueBase *> &reached, std::vector<ValueBase *> &pending)
+        : GcVisitor(true), reached(reached), pending(pending) {}
+    virtual void visit(ValueBase *p) override {
+        uint8_t color = p->gc_color.load(std::memory_order_relaxed);
+        if (color == GC_UNTRACKED) {
+            return;
+        }
+        if (color != GC_GREY) {
+            p->gc_color = GC_GREY;
+            p->gc_refs.store(referenceCount(p), std::memory_order_relaxed);
+            reached.push_back(p);
+            pending.push_back(p);
+        }
+        p->gc_refs.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+// Region reset: take out the references members hold to each other
+struct MemberVisitor : GcVisitor {
+    MemberVisitor() : GcVisitor(true) {}
+    virtual void visit(ValueBase *p) override {
+        if (p->gc_color.load(std::memory_order_relaxed) == GC_GREY) {
+            p->gc_refs.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+};
+
+// Trial deletion: whatever an externally held container reaches survives
+struct RestoreVisitor : GcVisitor {
+    std::vector<ValueBase *> &pending;
+    RestoreVisitor(std::vector<ValueBase *> &pending) : GcVisitor(true), pending(pending) {}
+    virtual void visit(ValueBase *p) override {
+        if (p->gc_color.load(std::memory_order_relaxed) == GC_GREY) {
+            p->gc_color = GC_BLACK;
+            pending.push_back(p);
+        }
+    }
+};
+
+/**
+ * @brief Synchronous cycle collection from the buffered possible roots
+ * Bacon and Rajan's trial deletion: take out the references the containers
+ * reachable from the roots hold to each other, bring back everything still
+ * reachable from a container with references left, and free the rest. Only
+ * the roots' subgraphs are visited, not the heap.
+ */
+size_t sweepUnreferenced(const std::vector<ValueBase *> &);
+
+void collectCandidates() {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start = Clock::now();
+    in_slice = true;
+    SlotTable &t = table();
+    std::vector<uint32_t> roots;
+    roots.swap(candidates);
+    std::vector<ValueBase *> reached, pending;
+    TrialVisitor trial(reached, pending);
+    for (uint32_t slot : roots) {
+        ValueBase *p = slot < t.end ? t.get(slot) : nullptr;
+        if (p != nullptr && p->gc_color.load(std::memory_order_relaxed) == GC_PURPLE) {
+            p->gc_color = GC_GREY;
+            p->gc_refs.store(referenceCount(p), std::memory_order_relaxed);
+            reached.push_back(p);
+            pending.push_back(p);
+        }
+    }
+    while (!pending.empty()) {
+        ValueBase *p = pending.back();
+        pending.pop_back();
+        p->traverse(trial);
+    }
+    size_t freed = sweepUnreferenced(reached);
+    in_slice = false;
+    // Roots inside a large live structure reach all of it every time; wait
+    // for as many roots as the last run reached so the work stays in step
+    candidate_limit = std::max(reached.size(), MIN_CANDIDATES);
+    stats.trial_deletions++;
+    stats.trial_freed += freed;
+    if (log_cycles) {
+        long us = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+        std::fprintf(stderr, "[gc trial %ld] %zu roots, %zu reached, %zu freed, %ld us\n",
+                     stats.trial_deletions, roots.size(), reached.size(), freed, us);
+    }
+}
+
+/**
+ * @brief Free the grey containers no outside reference keeps
+ * Each one's gc_refs holds its count less the references from the others.
+ * Returns how many were freed.
+ */
+size_t sweepUnreferenced(const std::vector<ValueBase *> &reached) {
+    std::vector<ValueBase *> pending;
+    RestoreVisitor restore(pending);
+    for (ValueBase *p : reached) {
+        if (p->gc_color.load(std::memory_order_relaxed) == GC_GREY && p->gc_refs.load(std::memory_order_relaxed) > 0) {
+            p->gc_color = GC_BLACK;
+            pending.push_back(p);
+            while (!pending.empty()) {
+                ValueBase *q = pending.back();
+                pending.pop_back();
+                q->traverse(restore);
+            }
+        }
+    }
+    std::vector<ValueBase *> garbage;
+    for (ValueBase *p : reached) {
+        if (p->gc_color.load(std::memory_order_relaxed) == GC_GREY) {
+            p->gc_color = GC_WHITE;
+            garbage.push_back(p);
+        }
+    }
+    if (!garbage.empty()) {
+        // The same clear-then-free as a cycle's sweep
+        pauseBiasedMerges(true);
+        phase = CLEAR;
+        for (ValueBase *p : garbage) {
+            p->clearRefs();
+        }
+        mergeAllBiasedCounts();
+        phase = FREE;
+        for (ValueBase *p : garbage) {
+            delete p;
+        }
+        phase = IDLE;
+        pauseBiasedMerges(false);
+    }
+    return garbage.size();
+}
+
+void collectorStep() {
+    if (in_slice) {
+        return;
+    }
+    heapDumpPoll();
+    if (phase == IDLE && candidates.size() >= candidate_limit) {
+        collectCandidates();
+    }
+    if (phase == IDLE) {
+        if (allocated < trigger) {
+            work_due = trigger;
+            return;
+        }
+        startCycle();
+    }
+    slice(stats.pause_target_us > 0 ? stats.pause_target_us : -1);
+    work_due = phase == IDLE ? trigger : allocated + SLICE_EVERY;
+}
+
+}
+
+void gcTrack(ValueBase *p) {
+    // Any slice runs before p joins the table: p has no count yet
+    long n = allocated.fetch_add(1, std::memory_order_relaxed) + 1;
+    if (!onPoolWorker() && (n >= work_due.load(std::memory_order_relaxed) || candidates.size() >= candidate_limit)
+        && poolIdle()) {
+        collectorStep();
+    }
+    SlotTable &t = table();
+    std::lock_guard<std::mutex> lock(t.lock);
+    uint32_t slot;
+    if (!t.free_slots.empty()) {
+        slot = t.free_slots.back();
+        t.free_slots.pop_back();
+    } else {
+        slot = t.end++;
+        if ((slot & (CHUNK - 1)) == 0) {
+            t.chunks.emplace_back(new std::atomic<ValueBase *>[CHUNK]);
+        }
+    }
+    t.at(slot).store(p, std::memory_order_relaxed);
+    t.live++;
+    if (regions) {
+        region.push_back(slot);
+    }
+    p->gc_slot = slot;
+    int ph = phase.load(std::memory_order_relaxed);
+    p->gc_color = (ph >= COUNT && ph <= MARK) ? GC_NEW : GC_BLACK;
+}
+
+void gcUntrack(ValueBase *p) {
+    SlotTable &t = table();
+    std::lock_guard<std::mutex> lock(t.lock);
+    t.at(p->gc_slot).store(nullptr, std::memory_order_relaxed);
+    t.free_slots.push_back(p->gc_slot);
+    t.live--;
+}
+
+void gcPossibleRoot(ValueBase *p) {
+    // Only the collecting thread buffers; cycles left by pool tasks wait for
+    // a whole-heap cycle
+    if ((p->v_type != V_PAIR && p->v_type != V_PROC && p->v_type != V_FRAME) || onPoolWorker()) {
+        return;
+    }
+    p->gc_color = GC_PURPLE;
+    candidates.push_back(p->gc_slot);
+}
+
+void gcShade(ValueBase *p) {
+    if (p->gc_color.load(std::memory_order_relaxed) == GC_WHITE) {
+        p->gc_color = GC_GREY;
+        grey.push_back(p->gc_slot);
+    }
+}
+
+bool gcSweeping() {
+    int ph = phase.load(std::memory_order_relaxed);
+    return ph == CLEAR || ph == FREE;
+}
+
+bool gcDying(ValueBase *p) {
+    int ph = phase.load(std::memory_order_relaxed);
+    if (ph == CLEAR || ph == FREE) {
+        // White containers are garbage; the sweep frees them
+        if (p->gc_color.load(std::memory_order_relaxed) == GC_WHITE) {
+            return false;
+        }
+        if (deferring) {
+            std::lock_guard<std::mutex> lock(deferred_lock);
+            deferred.push_back(p);
+            return false;
+        }
+        return true;
+    }
+    if (gc_barrier_on.load(std::memory_order_relaxed)) {
+        // Every reference it held is deleted at once
+        ShadeVisitor shade;
+        p->traverse(shade);
+    }
+    return true;
+}
+
+void gcFinishCycle() {
+    if (phase == IDLE || onPoolWorker() || in_slice) {
+        return;
+    }
+    slice(-1);
+    work_due = trigger;
+}
+
+size_t gcCollect() {
+    if (onPoolWorker() || !poolIdle() || in_slice) {
+        return 0;
+    }
+    gcFinishCycle();
+    startCycle();
+    slice(-1);
+    work_due = trigger;
+    return stats.last_freed;
+}
+
+void gcEndRegion() {
+    if (!regions) {
+        return;
+    }
+    std::vector<uint32_t> slots;
+    SlotTable &t = table();
+    {
+        std::lock_guard<std::mutex> lock(t.lock);
+        slots.swap(region);
+    }
+    if (onPoolWorker() || !poolIdle() || in_slice) {
+        return;
+    }
+    gcFinishCycle();
+    in_slice = true;
+    std::vector<ValueBase *> members;
+    for (uint32_t slot : slots) {
+        ValueBase *p = t.get(slot);
+        uint8_t color = p != nullptr ? p->gc_color.load(std::memory_order_relaxed) : (uint8_t)GC_UNTRACKED;
+        if (color == GC_BLACK || color == GC_PURPLE) {
+            p->gc_color = GC_GREY;
+            p->gc_refs.store(referenceCount(p), std::memory_order_relaxed);
+            members.push_back(p);
+        }
+    }
+    MemberVisitor member;
+    for (ValueBase *p : members) {
+        p->traverse(member);
+    }
+    stats.region_freed += sweepUnreferenced(members);
+    in_slice = false;
+}
+
+const GcStats &gcStats() {
+    return stats;
+}
+
+void gcWithContainers(const std::function<void(const std::vector<ValueBase *> &)> &fn) {
+    // A cycle in progress already holds the merges
+    bool hold = phase == IDLE;
+    if (hold) {
+        pauseBiasedMerges(true);
+        mergeAllBiasedCounts();
+    }
+    std::vector<ValueBase *> all;
+    SlotTable &t = table();
+    {
+        std::lock_guard<std::mutex> lock(t.lock);
+        all.reserve(t.live);
+        for (uint32_t i = 0; i < t.end; i++) {
+            if (ValueBase *p = t.get(i)) {
+                all.push_back(p);
+            }
+        }
+    }
+    try {
+        fn(all);
+    } catch (...) {
+        if (hold) {
+            pauseBiasedMerges(false);
+        }
+        throw;
+    }
+    if (hold) {
+        pauseBiasedMerges(false);
+    }
+}
+
+void gcRequestStep() {
+    work_due.store(0, std::memory_order_relaxed);
+}
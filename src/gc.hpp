@@ -0,0 +1,164 @@
+#ifndef GC_HPP
+#define GC_HPP
+
+/**
+ * @file gc.hpp
+ * @brief Incremental cycle collector over the reference-counted heap
+ *
+ * Reference counting frees acyclic garbage straight away; this collector
+ * finds the cycles it cannot (closures stored in their own environment,
+ * lists tied into rings with set-cdr!). Every container value (pairs,
+ * vectors, procedures, promises, records, error objects, environment frames,
+ * hashtables) sits in a slot table. A cycle
+ *
+ *   1. snapshots the reference count of every container,
+ *   2. subtracts from those the references containers hold to each other,
+ *      leaving the references from outside the heap (the C++ stack, Expr
+ *      nodes, immortal literals) as roots,
+ *   3. marks everything reachable from the roots,
+ *   4. clears the fields of whatever is left unmarked, then frees it.
+ *
+ * Each step runs in slices interleaved with allocation, each slice stopping
+ * at the first unit of work that ends past the pause target. The target is
+ * not a bound: a unit that visits many references, or the thread being
+ * descheduled, overruns it, and gc-stats counts the slices that did.
+ * Between slices the mutator runs; a deletion write barrier
+ * (gcWriteBarrier) on every store that overwrites a reference held by a
+ * container, plus the same shading for the references of a container that
+ * dies mid-cycle, keeps whatever was reachable when the cycle began from
+ * being collected. Containers allocated during a cycle survive it.
+ *
+ * With SCHEME_GC_TRIAL=1, a pair, procedure or frame whose count drops
+ * without reaching zero is also buffered as a possible cycle root. Once
+ * enough have piled up, trial deletion (Bacon-Rajan) runs synchronously
+ * over the containers they reach, so most cycles go long before the next
+ * heap-wide collection. It is off by default: buffering costs every drop.
+ *
+ * With SCHEME_GC_REGIONS=1, every container allocated while a top-level
+ * form runs belongs to that form's region. When the form is done, the
+ * region's members that something outside the region still references
+ * (a global binding, an older container) are promoted, along with what
+ * they reach; the rest are freed in one sweep, cycles included.
+ *
+ * Cycles run on the main thread while no pool task is in flight; submitting
+ * a task finishes the current cycle first. A cycle run to completion (an
+ * explicit collection, one finished before a task, or any cycle with a zero
+ * pause target) on a heap of more than 64k slots splits each step across
+ * the pool's threads.
+ *
+ * SCHEME_GC_PAUSE_US sets the pause target in microseconds, 0 for whole
+ * cycles with no slicing, and SCHEME_GC_LOG=1 reports each collection on
+ * stderr.
+ */
+
+#include "value.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Callback for the references a container holds
+ *
+ * When exact is set only references that account for exactly one count on
+ * their target are wanted; the subtraction step needs that, so containers
+ * skip references they reach through structures other values may share.
+ */
+struct GcVisitor {
+    bool exact;
+    GcVisitor(bool exact) : exact(exact) {}
+    virtual void visit(ValueBase *) = 0;
+    void operator()(const Value &v) {
+        if (v.get() != nullptr) {
+            visit(v.get());
+        }
+    }
+    void operator()(const Assoc &a) {
+        (*this)(a.ptr);
+    }
+};
+
+/**
+ * @brief Per-collection statistics
+ */
+struct GcStats {
+    long collections;
+    size_t freed_total;
+    size_t last_objects;     ///< Containers in the last cycle's snapshot
+    size_t last_freed;
+    long last_slices;
+    long last_max_pause_us;  ///< Longest slice of the last cycle
+    long last_over_target;   ///< Slices of the last cycle longer than the target
+    long last_total_us;      ///< All slices of the last cycle together
+    long pause_target_us;
+    long last_threads;       ///< Threads that shared the last cycle
+    long trial_deletions;    ///< Collections from the possible-root buffer
+    size_t trial_freed;
+    size_t region_freed;     ///< Freed by region resets
+};
+
+void gcTrack(ValueBase *);
+void gcUntrack(ValueBase *);
+
+/**
+ * @brief Called before a container whose count reached zero is deleted
+ * Returns false when the sweep will free it instead.
+ */
+bool gcDying(ValueBase *);
+
+extern std::atomic<bool> gc_barrier_on;   ///< A cycle is counting or marking
+void gcShade(ValueBase *);
+
+/**
+ * @brief Whether a cycle is clearing or freeing: white containers are garbage
+ */
+bool gcSweeping();
+
+/**
+ * @brief Deletion barrier: call with the reference a container is about
+ * to overwrite
+ */
+inline void gcWriteBarrier(const Value &old) {
+    if (gc_barrier_on.load(std::memory_order_relaxed) && old.get() != nullptr) {
+        gcShade(old.get());
+    }
+}
+
+inline void gcWriteBarrier(const Assoc &old) {
+    gcWriteBarrier(old.ptr);
+}
+
+/**
+ * @brief End the current region: free what the top-level form just
+ * evaluated left unreferenced, and start the next one
+ */
+void gcEndRegion();
+
+/**
+ * @brief Run any cycle in progress to completion
+ */
+void gcFinishCycle();
+
+/**
+ * @brief Run a whole collection now
+ * Returns the number of containers freed, 0 if pool tasks are in flight.
+ */
+size_t gcCollect();
+
+const GcStats &gcStats();
+
+/**
+ * @brief Hand fn every tracked container, their counts held still
+ * Counts stay put until fn returns. Only on the main thread while no pool
+ * task is in flight.
+ */
+void gcWithContainers(const std::function<void(const std::vector<ValueBase *> &)> &fn);
+
+/**
+ * @brief Have the next allocation on the main thread step the collector
+ * Safe in a signal handler.
+ */
+void gcRequestStep();
+
+#endif
@@ -0,0 +1,319 @@
+/**
+ * @file heap.cpp
+ * @brief Size-classed arenas and per-thread cell caches
+ *
+ * An arena starts with its header, so any cell finds its arena by masking
+ * its address. Arenas with free cells sit on their class's list; the class
+ * lock guards the list and every arena on it. The thread caches are only
+ * touched by their own thread.
+ */
+
+#include "heap.hpp"
+#include "gc.hpp"
+#include "RE.hpp"
+#include <sys/mman.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <vector>
+
+// AddressSanitizer only checks what comes from its own allocator
+#if defined(__SANITIZE_ADDRESS__)
+#define HEAP_ARENAS 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define HEAP_ARENAS 0
+#endif
+#endif
+#ifndef HEAP_ARENAS
+#define HEAP_ARENAS 1
+#endif
+
+namespace {
+
+const size_t ARENA_BYTES = 2u << 20;
+const size_t GRAIN = 16;
+const size_t MAX_CELL = 256;
+const size_t CLASSES = MAX_CELL / GRAIN;
+const uint32_t BATCH = 32;   ///< Cells moved between a thread and the arenas at a time
+const size_t DEFAULT_LIMIT_MB = 192;
+
+struct Cell {
+    Cell *next;
+};
+
+struct Arena {
+    size_t cell;
+    size_t live;        ///< Cells handed out, thread caches included
+    char *bump;         ///< Start of the cells never handed out
+    char *end;
+    Cell *free;
+    Arena *prev;        ///< Neighbours among its class's arenas with room
+    Arena *next;
+    bool listed;
+};
+
+const size_t HEADER = (sizeof(Arena) + 63) & ~(size_t)63;
+
+struct SizeClass {
+    std::mutex lock;
+    Arena *room = nullptr;
+};
+
+/**
+ * @brief Every size class and the spare arenas
+ * Allocated once and never freed: values held by static objects are freed
+ * during exit.
+ */
+struct Heap {
+    Heap() {
+        limit = DEFAULT_LIMIT_MB << 20;
+        if (const char *env = std::getenv("SCHEME_HEAP_LIMIT_MB")) {
+            limit = (size_t)std::max(0L, std::atol(env)) << 20;
+        }
+    }
+    SizeClass classes[CLASSES];
+    std::atomic<size_t> limit;    ///< Cap on arena, large and buffer bytes, 0 for none
+    std::mutex spare_lock;
+    std::vector<char *> spare;
+    std::atomic<size_t> arenas{0};
+    std::atomic<size_t> cell_bytes{0};
+    std::atomic<size_t> large_bytes{0};
+    std::atomic<size_t> buffer_bytes{0};
+    std::atomic<size_t> released{0};
+    std::atomic<size_t> failures{0};
+};
+
+Heap &heap() {
+    static Heap *h = new Heap();
+    return *h;
+}
+
+struct Cache {
+    Cell *head[CLASSES];
+    uint32_t count[CLASSES];
+};
+
+thread_local Cache cache;
+
+bool overLimit(size_t more) {
+    Heap &h = heap();
+    size_t limit = h.limit;
+    return limit != 0 && h.arenas * ARENA_BYTES + h.large_bytes + h.buffer_bytes + more > limit;
+}
+
+Arena *arenaOf(void *p) {
+    return (Arena *)((uintptr_t)p & ~(uintptr_t)(ARENA_BYTES - 1));
+}
+
+// Map twice the size and trim, for an arena aligned to its size
+char *mapArena() {
+    size_t span = 2 * ARENA_BYTES;
+    void *m = mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    uintptr_t start = (uintptr_t)m;
+    uintptr_t aligned = (start + ARENA_BYTES - 1) & ~(uintptr_t)(ARENA_BYTES - 1);
+    if (aligned > start) {
+        munmap(m, aligned - start);
+    }
+    uintptr_t tail = start + span - (aligned + ARENA_BYTES);
+    if (tail > 0) {
+        munmap((void *)(aligned + ARENA_BYTES), tail);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise((void *)aligned, ARENA_BYTES, MADV_HUGEPAGE);
+#endif
+    return (char *)aligned;
+}
+
+Arena *newArena(size_t cell) {
+    Heap &h = heap();
+    char *base = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(h.spare_lock);
+        if (!h.spare.empty()) {
+            base = h.spare.back();
+            h.spare.pop_back();
+        }
+    }
+    if (base == nullptr) {
+        base = mapArena();
+    }
+    Arena *a = new (base) Arena();
+    a->cell = cell;
+    a->live = 0;
+    a->bump = base + HEADER;
+    a->end = a->bump + (ARENA_BYTES - HEADER) / cell * cell;
+    a->free = nullptr;
+    a->prev = a->next = nullptr;
+    a->listed = false;
+    h.arenas++;
+    return a;
+}
+
+void list(SizeClass &c, Arena *a) {
+    a->prev = nullptr;
+    a->next = c.room;
+    if (c.room != nullptr) {
+        c.room->prev = a;
+    }
+    c.room = a;
+    a->listed = true;
+}
+
+void unlist(SizeClass &c, Arena *a) {
+    if (a->prev != nullptr) {
+        a->prev->next = a->next;
+    } else {
+        c.room = a->next;
+    }
+    if (a->next != nullptr) {
+        a->next->prev = a->prev;
+    }
+    a->listed = false;
+}
+
+void releaseArena(SizeClass &c, Arena *a) {
+    Heap &h = heap();
+    unlist(c, a);
+    madvise(a, ARENA_BYTES, MADV_DONTNEED);
+    h.arenas--;
+    h.released++;
+    std::lock_guard<std::mutex> lock(h.spare_lock);
+    h.spare.push_back((char *)a);
+}
+
+// Fill the cache, short of mapping past the limit; false when nothing came
+bool refill(size_t k) {
+    Heap &h = heap();
+    SizeClass &c = h.classes[k];
+    size_t cell = (k + 1) * GRAIN;
+    std::lock_guard<std::mutex> lock(c.lock);
+    Cell *head = cache.head[k];
+    uint32_t n = 0;
+    for (; n < BATCH; n++) {
+        Arena *a = c.room;
+        if (a == nullptr) {
+            if (overLimit(ARENA_BYTES)) {
+                break;
+            }
+            a = newArena(cell);
+            list(c, a);
+        }
+        Cell *x;
+        if (a->free != nullptr) {
+            x = a->free;
+            a->free = x->next;
+        } else {
+            x = (Cell *)a->bump;
+            a->bump += cell;
+        }
+        a->live++;
+        if (a->free == nullptr && a->bump == a->end) {
+            unlist(c, a);
+        }
+        x->next = head;
+        head = x;
+    }
+    cache.head[k] = head;
+    cache.count[k] += n;
+    h.cell_bytes += n * cell;
+    return n > 0;
+}
+
+void flush(size_t k, uint32_t n) {
+    Heap &h = heap();
+    SizeClass &c = h.classes[k];
+    std::lock_guard<std::mutex> lock(c.lock);
+    for (uint32_t i = 0; i < n; i++) {
+        Cell *x = cache.head[k];
+        cache.head[k] = x->next;
+        Arena *a = arenaOf(x);
+        x->next = a->free;
+        a->free = x;
+        if (!a->listed) {
+            list(c, a);
+        }
+        // Keep the last arena with room, so one cell going back and forth
+        // does not map and drop an arena every time
+        if (--a->live == 0 && (c.room != a || a->next != nullptr)) {
+            releaseArena(c, a);
+        }
+    }
+    cache.count[k] -= n;
+    h.cell_bytes -= n * (k + 1) * GRAIN;
+}
+
+// Before the value is constructed, so a throw leaves nothing half made
+void outOfMemory() {
+    heap().failures++;
+    throw RuntimeError("out of memory");
+}
+
+}
+
+void *heapAlloc(size_t size) {
+    if (!HEAP_ARENAS || size > MAX_CELL) {
+        if (overLimit(size) && (gcCollect(), overLimit(size))) {
+            outOfMemory();
+        }
+        heap().large_bytes += size;
+        return ::operator new(size);
+    }
+    size_t k = (size - 1) / GRAIN;
+    // A collection frees cells into this thread's cache, which may be enough on its own
+    if (cache.head[k] == nullptr && !refill(k) && (gcCollect(), cache.head[k] == nullptr && !refill(k))) {
+        outOfMemory();
+    }
+    Cell *x = cache.head[k];
+    cache.head[k] = x->next;
+    cache.count[k]--;
+    return x;
+}
+
+void heapFree(void *p, size_t size) {
+    if (!HEAP_ARENAS || size > MAX_CELL) {
+        heap().large_bytes -= size;
+        ::operator delete(p);
+        return;
+    }
+    size_t k = (size - 1) / GRAIN;
+    Cell *x = (Cell *)p;
+    x->next = cache.head[k];
+    cache.head[k] = x;
+    if (++cache.count[k] > 2 * BATCH) {
+        flush(k, BATCH);
+    }
+}
+
+void heapReserve(size_t bytes) {
+    if (overLimit(bytes) && (gcCollect(), overLimit(bytes))) {
+        outOfMemory();
+    }
+    heap().buffer_bytes += bytes;
+}
+
+void heapUnreserve(size_t bytes) {
+    heap().buffer_bytes -= bytes;
+}
+
+HeapStats heapStats() {
+    Heap &h = heap();
+    size_t spare;
+    {
+        std::lock_guard<std::mutex> lock(h.spare_lock);
+        spare = h.spare.size();
+    }
+    size_t arenas = h.arenas;
+    return HeapStats{arenas, spare, arenas * ARENA_BYTES, h.cell_bytes, h.large_bytes, h.buffer_bytes,
+                     h.released, h.limit, h.failures};
+}
+
+size_t heapSetLimit(size_t bytes) {
+    return heap().limit.exchange(bytes);
+}
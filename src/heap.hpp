@@ -0,0 +1,58 @@
+#ifndef HEAP_HPP
+#define HEAP_HPP
+
+/**
+ * @file heap.hpp
+ * @brief Arena allocator behind every value
+ *
+ * Values up to 256 bytes come from 2 MiB arenas mapped straight from the
+ * kernel, aligned to their size and advised as huge pages, so a list-heavy
+ * heap sits on few TLB entries. Each arena holds cells of one size class.
+ * Threads keep a short free list per class and trade cells with the arenas
+ * in batches. An arena whose cells are all free goes back to the kernel
+ * with MADV_DONTNEED and stays mapped for reuse, so resident memory follows
+ * the live heap. Larger values use operator new.
+ *
+ * Arenas, large values and the storage values own outside their cells
+ * (vector elements, string characters, bytevector bytes) together are
+ * capped at SCHEME_HEAP_LIMIT_MB (192 MiB by default, 0 for no cap;
+ * heap-limit! changes it at run time). An allocation that would pass the
+ * cap runs a full collection first, then throws RuntimeError("out of memory").
+ */
+
+#include <cstddef>
+
+/**
+ * @brief Arena and allocation counters
+ */
+struct HeapStats {
+    size_t arenas;           ///< Arenas holding cells
+    size_t spare_arenas;     ///< Mapped, emptied and returned to the kernel
+    size_t arena_bytes;      ///< Bytes in arenas holding cells
+    size_t cell_bytes;       ///< Cells handed out, thread caches included
+    size_t large_bytes;      ///< Values allocated outside the arenas
+    size_t buffer_bytes;     ///< Storage values own outside their cells
+    size_t released;         ///< Times an arena was returned to the kernel
+    size_t limit_bytes;      ///< Cap on arena, large and buffer bytes, 0 for none
+    size_t failures;         ///< Allocations refused at the cap
+};
+
+void *heapAlloc(size_t);
+void heapFree(void *, size_t);
+
+/**
+ * @brief Count storage a value owns against the cap, before allocating it
+ * Throws like heapAlloc when it does not fit.
+ */
+void heapReserve(size_t);
+void heapUnreserve(size_t);
+
+HeapStats heapStats();
+
+/**
+ * @brief Set the cap in bytes, 0 for none; yields the previous one
+ * Takes effect at the next arena or large value allocated.
+ */
+size_t heapSetLimit(size_t);
+
+#endif
@@ -0,0 +1,389 @@
+/**
+ * @file macro.cpp
+ * @brief syntax-rules macro transformers
+ *
+ * Macros are expanded by List::parse, so every use site is rewritten into
+ * ordinary syntax exactly once and the evaluator never sees a macro. The
+ * rule that matched a given input shape is remembered per macro, so repeated
+ * uses of the same shape skip straight to the right rule.
+ */
+
+#include "syntax.hpp"
+#include "RE.hpp"
+#include <atomic>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace {
+
+/**
+ * @brief What a pattern variable matched
+ *
+ * Variables under an ellipsis match a sequence, one entry per repetition.
+ */
+struct MatchTree {
+    Syntax stx;
+    bool is_seq;
+    vector<MatchTree> seq;
+    MatchTree() : stx(nullptr), is_seq(true) {}
+    explicit MatchTree(const Syntax &s) : stx(s), is_seq(false) {}
+};
+
+typedef std::map<string, MatchTree> Bindings;
+
+}
+
+static std::map<string, SyntaxRules> macros;
+static std::atomic<int> gensym_counter(0);
+
+static SymbolSyntax *asSymbol(const Syntax &s) {
+    return dynamic_cast<SymbolSyntax*>(s.get());
+}
+
+static List *asList(const Syntax &s) {
+    return dynamic_cast<List*>(s.get());
+}
+
+static bool isSymbol(const Syntax &s, const char *name) {
+    SymbolSyntax *sym = asSymbol(s);
+    return sym != nullptr && sym->s == name;
+}
+
+static bool isEllipsis(const Syntax &s) {
+    return isSymbol(s, "...");
+}
+
+bool SyntaxRules::isLiteral(const string &s) const {
+    for (auto &lit : literals)
+        if (lit == s)
+            return true;
+    return false;
+}
+
+// Constants in patterns match equal constants in the input
+static bool sameDatum(const Syntax &a, const Syntax &b) {
+    if (Number *x = dynamic_cast<Number*>(a.get())) {
+        Number *y = dynamic_cast<Number*>(b.get());
+        return y != nullptr && x->n == y->n;
+    }
+    if (StringSyntax *x = dynamic_cast<StringSyntax*>(a.get())) {
+        StringSyntax *y = dynamic_cast<StringSyntax*>(b.get());
+        return y != nullptr && x->s == y->s;
+    }
+    if (CharSyntax *x = dynamic_cast<CharSyntax*>(a.get())) {
+        CharSyntax *y = dynamic_cast<CharSyntax*>(b.get());
+        return y != nullptr && x->c == y->c;
+    }
+    if (dynamic_cast<TrueSyntax*>(a.get()))
+        return dynamic_cast<TrueSyntax*>(b.get()) != nullptr;
+    if (dynamic_cast<FalseSyntax*>(a.get()))
+        return dynamic_cast<FalseSyntax*>(b.get()) != nullptr;
+    return false;
+}
+
+static void patternVars(const Syntax &pat, const SyntaxRules &m, std::set<string> &out) {
+    if (SymbolSyntax *sym = asSymbol(pat)) {
+        if (sym->s != "..." && sym->s != "_" && sym->s != "." && !m.isLiteral(sym->s))
+            out.insert(sym->s);
+    } else if (List *l = asList(pat)) {
+        for (auto &s : l->stxs)
+            patternVars(s, m, out);
+    }
+}
+
+static bool match(const Syntax &pat, const Syntax &form, const SyntaxRules &m, Bindings &b);
+
+static bool matchList(const vector<Syntax> &ps, const vector<Syntax> &fs,
+                      const SyntaxRules &m, Bindings &b) {
+    size_t np = ps.size();
+    Syntax tail(nullptr);
+    if (np >= 2 && isSymbol(ps[np - 2], ".")) {
+        tail = ps[np - 1];
+        np -= 2;
+    }
+    size_t ell = np;
+    for (size_t i = 0; i + 1 < np; i++) {
+        if (isEllipsis(ps[i + 1])) {
+            ell = i;
+            break;
+        }
+    }
+
+    if (ell == np) {
+        if (tail.get() == nullptr ? fs.size() != np : fs.size() < np)
+            return false;
+        for (size_t i = 0; i < np; i++)
+            if (!match(ps[i], fs[i], m, b))
+                return false;
+        if (tail.get() != nullptr) {
+            List *rest = new List();
+            rest->stxs.assign(fs.begin() + np, fs.end());
+            return match(tail, Syntax(rest), m, b);
+        }
+        return true;
+    }
+
+    size_t after = np - ell - 2;
+    if (fs.size() < ell + after)
+        return false;
+    size_t reps = fs.size() - ell - after;
+    for (size_t i = 0; i < ell; i++)
+        if (!match(ps[i], fs[i], m, b))
+            return false;
+
+    std::set<string> vars;
+    patternVars(ps[ell], m, vars);
+    for (auto &v : vars)
+        b[v] = MatchTree();
+    for (size_t k = 0; k < reps; k++) {
+        Bindings sub;
+        if (!match(ps[ell], fs[ell + k], m, sub))
+            return false;
+        for (auto &v : vars)
+            b[v].seq.push_back(sub[v]);
+    }
+    for (size_t j = 0; j < after; j++)
+        if (!match(ps[ell + 2 + j], fs[ell + reps + j], m, b))
+            return false;
+    if (tail.get() != nullptr)
+        return match(tail, Syntax(new List()), m, b);
+    return true;
+}
+
+static bool match(const Syntax &pat, const Syntax &form, const SyntaxRules &m, Bindings &b) {
+    if (SymbolSyntax *p = asSymbol(pat)) {
+        if (p->s == "_")
+            return true;
+        if (m.isLiteral(p->s)) {
+            SymbolSyntax *f = asSymbol(form);
+            return f != nullptr && f->s == p->s;
+        }
+        b[p->s] = MatchTree(form);
+        return true;
+    }
+    if (List *pl = asList(pat)) {
+        List *fl = asList(form);
+        if (fl == nullptr)
+            return false;
+        return matchList(pl->stxs, fl->stxs, m, b);
+    }
+    return sameDatum(pat, form);
+}
+
+// A use matches a rule on everything but the keyword itself
+static bool matchRule(const Syntax &pat, const List *form, const SyntaxRules &m, Bindings &b) {
+    List *pl = asList(pat);
+    if (pl == nullptr || pl->stxs.empty())
+        throw RuntimeError("syntax-rules pattern must be a non-empty list");
+    vector<Syntax> ps(pl->stxs.begin() + 1, pl->stxs.end());
+    vector<Syntax> fs(form->stxs.begin() + 1, form->stxs.end());
+    return matchList(ps, fs, m, b);
+}
+
+static Syntax expand(const Syntax &tmpl, const Bindings &b, const std::map<string, string> &renames);
+
+static void seqVars(const Syntax &tmpl, const Bindings &b, std::set<string> &out) {
+    if (SymbolSyntax *sym = asSymbol(tmpl)) {
+        auto it = b.find(sym->s);
+        if (it != b.end() && it->second.is_seq)
+            out.insert(sym->s);
+    } else if (List *l = asList(tmpl)) {
+        for (auto &s : l->stxs)
+            seqVars(s, b, out);
+    }
+}
+
+static void expandEllipsis(const Syntax &tmpl, size_t depth, const Bindings &b,
+                           const std::map<string, string> &renames, vector<Syntax> &out) {
+    std::set<string> vars;
+    seqVars(tmpl, b, vars);
+    if (vars.empty())
+        throw RuntimeError("syntax-rules template has no pattern variable before ellipsis");
+    size_t reps = b.at(*vars.begin()).seq.size();
+    for (auto &v : vars)
+        if (b.at(v).seq.size() != reps)
+            throw RuntimeError("syntax-rules ellipsis lengths differ");
+    for (size_t k = 0; k < reps; k++) {
+        Bindings local = b;
+        for (auto &v : vars)
+            local[v] = b.at(v).seq[k];
+        if (depth > 1)
+            expandEllipsis(tmpl, depth - 1, local, renames, out);
+        else
+            out.push_back(expand(tmpl, local, renames));
+    }
+}
+
+static Syntax expand(const Syntax &tmpl, const Bindings &b, const std::map<string, string> &renames) {
+    if (SymbolSyntax *sym = asSymbol(tmpl)) {
+        auto it = b.find(sym->s);
+        if (it != b.end()) {
+            if (it->second.is_seq)
+                throw RuntimeError("syntax-rules pattern variable used without ellipsis: " + sym->s);
+            return it->second.stx;
+        }
+        auto r = renames.find(sym->s);
+        if (r != renames.end())
+            return Syntax(new SymbolSyntax(r->second));
+        return tmpl;
+    }
+    List *l = asList(tmpl);
+    if (l == nullptr)
+        return tmpl;
+    // (... ...) escapes a literal ellipsis
+    if (l->stxs.size() == 2 && isEllipsis(l->stxs[0]))
+        return l->stxs[1];
+    List *out = new List();
+    Syntax result(out);
+    for (size_t i = 0; i < l->stxs.size(); i++) {
+        size_t depth = 0;
+        while (i + 1 + depth < l->stxs.size() && isEllipsis(l->stxs[i + 1 + depth]))
+            depth++;
+        if (depth == 0) {
+            out->stxs.push_back(expand(l->stxs[i], b, renames));
+        } else {
+            expandEllipsis(l->stxs[i], depth, b, renames, out->stxs);
+            i += depth;
+        }
+    }
+    return result;
+}
+
+static void addBinder(const Syntax &s, const std::set<string> &pvars, std::set<string> &out) {
+    SymbolSyntax *sym = asSymbol(s);
+    if (sym != nullptr && sym->s != "..." && sym->s != "." && pvars.count(sym->s) == 0)
+        out.insert(sym->s);
+}
+
+// Names a template binds itself (lambda parameters, let/letrec variables)
+// are renamed on every expansion, so they cannot capture the user's names.
+static void collectBinders(const Syntax &tmpl, const std::set<string> &pvars, std::set<string> &out) {
+    List *l = asList(tmpl);
+    if (l == nullptr)
+        return;
+    if (l->stxs.size() >= 2) {
+        if (isSymbol(l->stxs[0], "lambda")) {
+            if (List *params = asList(l->stxs[1])) {
+                for (auto &p : params->stxs)
+                    addBinder(p, pvars, out);
+            } else {
+                addBinder(l->stxs[1], pvars, out);
+            }
+        } else if (isSymbol(l->stxs[0], "let") || isSymbol(l->stxs[0], "let*") ||
+                   isSymbol(l->stxs[0], "letrec")) {
+            size_t at = 1;
+            if (asSymbol(l->stxs[1]) != nullptr) {
+                addBinder(l->stxs[1], pvars, out);
+                at = 2;
+            }
+            if (at < l->stxs.size()) {
+                if (List *binds = asList(l->stxs[at])) {
+                    for (auto &bind : binds->stxs) {
+                        List *pair = asList(bind);
+                        if (pair != nullptr && !pair->stxs.empty())
+                            addBinder(pair->stxs[0], pvars, out);
+                    }
+                }
+            }
+        }
+    }
+    for (auto &s : l->stxs)
+        collectBinders(s, pvars, out);
+}
+
+void defineSyntax(const string &name, const Syntax &spec) {
+    List *sr = asList(spec);
+    if (sr == nullptr || sr->stxs.size() < 2 || !isSymbol(sr->stxs[0], "syntax-rules"))
+        throw RuntimeError("define-syntax expects a syntax-rules transformer");
+    List *lits = asList(sr->stxs[1]);
+    if (lits == nullptr)
+        throw RuntimeError("syntax-rules literals must be a list");
+
+    SyntaxRules m;
+    for (auto &lit : lits->stxs) {
+        SymbolSyntax *sym = asSymbol(lit);
+        if (sym == nullptr)
+            throw RuntimeError("syntax-rules literals must be symbols");
+        m.literals.push_back(sym->s);
+    }
+    for (size_t i = 2; i < sr->stxs.size(); i++) {
+        List *rule = asList(sr->stxs[i]);
+        if (rule == nullptr || rule->stxs.size() != 2)
+            throw RuntimeError("syntax-rules rule must be (pattern template)");
+        std::set<string> pvars;
+        patternVars(rule->stxs[0], m, pvars);
+        std::set<string> binders;
+        collectBinders(rule->stxs[1], pvars, binders);
+        m.rules.push_back(std::make_pair(rule->stxs[0], rule->stxs[1]));
+        m.binders.push_back(vector<string>(binders.begin(), binders.end()));
+    }
+    macros[name] = m;
+}
+
+bool isMacro(const string &name) {
+    return macros.count(name) != 0;
+}
+
+// Everything matching depends on: list structure, literals and constants.
+// Each kind has its own tag, so no literal name or string spells another.
+static void shapeOf(const Syntax &s, const SyntaxRules &m, string &key) {
+    if (SymbolSyntax *sym = asSymbol(s)) {
+        key += m.isLiteral(sym->s) ? "L:" + sym->s : string("v");
+    } else if (List *l = asList(s)) {
+        key += '(';
+        for (auto &x : l->stxs)
+            shapeOf(x, m, key);
+        key += ')';
+    } else if (Number *num = dynamic_cast<Number*>(s.get())) {
+        key += 'n' + std::to_string(num->n);
+    } else if (StringSyntax *str = dynamic_cast<StringSyntax*>(s.get())) {
+        key += '"' + std::to_string(str->s.size()) + ':' + str->s;
+    } else if (CharSyntax *ch = dynamic_cast<CharSyntax*>(s.get())) {
+        key += "#\\" + charName(ch->c);
+    } else if (dynamic_cast<TrueSyntax*>(s.get())) {
+        key += "#t";
+    } else if (dynamic_cast<FalseSyntax*>(s.get())) {
+        key += "#f";
+    } else {
+        key += '?';
+    }
+    key += ' ';
+}
+
+Syntax expandMacro(const string &name, List *fl) {
+    SyntaxRules &m = macros.at(name);
+    string key;
+    for (size_t i = 1; i < fl->stxs.size(); i++)
+        shapeOf(fl->stxs[i], m, key);
+
+    Bindings b;
+    int rule = -1;
+    auto hit = m.shape_cache.find(key);
+    if (hit != m.shape_cache.end()) {
+        rule = hit->second;
+        if (rule >= 0)
+            matchRule(m.rules[rule].first, fl, m, b);
+    } else {
+        for (size_t i = 0; i < m.rules.size(); i++) {
+            b.clear();
+            if (matchRule(m.rules[i].first, fl, m, b)) {
+                rule = i;
+                break;
+            }
+        }
+        m.shape_cache[key] = rule;
+    }
+    if (rule < 0)
+        throw RuntimeError("No syntax rule matches use of " + name);
+
+    std::map<string, string> renames;
+    int stamp = ++gensym_counter;
+    for (auto &x : m.binders[rule])
+        renames[x] = x + "%" + std::to_string(stamp);
+    return expand(m.rules[rule].second, b, renames);
+}
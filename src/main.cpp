@@ -3,6 +3,8 @@
 #include "expr.hpp"
 #include "value.hpp"
 #include "RE.hpp"
+#include "gc.hpp"
+#include "dump.hpp"
 #include <sstream>
 #include <iostream>
 #include <map>
@@ -48,6 +50,8 @@ bool isExplicitVoidCall(Expr expr) {
 void REPL(){
     // read - evaluation - print loop
     Assoc global_env = empty();
+    heapDumpGlobals(&global_env);
+    installHeapDumpSignal();
     while (std::cin.good()){
         #ifndef ONLINE_JUDGE
             std::cout << "scm> ";
@@ -62,6 +66,11 @@ void REPL(){
             }
         }
         Syntax stx = readSyntax(std :: cin); // read
+        // Input read by the program starts on the line after the form
+        while (std::cin.peek() == ' ' || std::cin.peek() == '\t' || std::cin.peek() == '\r')
+            std::cin.get();
+        if (std::cin.peek() == '\n')
+            std::cin.get();
         // Check if we actually read anything
         try{
             Expr expr = stx -> parse(global_env); // parse
@@ -75,7 +84,18 @@ void REPL(){
             // std :: cout << RE.message();
             std :: cout << "RuntimeError";
         }
+        catch (const SchemeRaise &){
+            // raised with no handler installed
+            std :: cout << "RuntimeError";
+        }
+        catch (const ContinuationThrow &){
+            // a continuation invoked after its call/cc returned
+            std :: cout << "RuntimeError";
+        }
         puts("");
+        mergeBiasedCounts();
+        gcEndRegion();
+        heapDumpPoll();
     }
 }
 
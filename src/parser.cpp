@@ -24,6 +24,251 @@ using std::pair;
 extern std::map<std::string, ExprType> primitives;
 extern std::map<std::string, ExprType> reserved_words;
 
+/**
+ * @brief Record locally bound names in the parse-time environment
+ *
+ * A name bound by lambda, let or letrec shadows any primitive, reserved word
+ * or macro of the same name inside its body, so the body is parsed in an
+ * environment where the name is found.
+ */
+static Assoc bindLocals(const vector<string> &names, Assoc env) {
+    for (auto &x : names)
+        env = extend(x, VoidV(), env);
+    return env;
+}
+
+/**
+ * @brief Read a formals list into fixed names and an optional rest name
+ *
+ * Accepts (a b), (a b . rest) and a lone symbol, which takes every argument.
+ * The first `skip` elements are not formals, as in (define (f . args) ...).
+ */
+static void parseFormals(const Syntax &stx, size_t skip, vector<string> &fixed, string &rest) {
+    if (SymbolSyntax* all = dynamic_cast<SymbolSyntax*>(stx.get())) {
+        if (skip > 0) {
+            throw RuntimeError("Invalid formals");
+        }
+        rest = all->s;
+        return;
+    }
+    List* formals = dynamic_cast<List*>(stx.get());
+    if (!formals) {
+        throw RuntimeError("Formals must be a list");
+    }
+    for (size_t i = skip; i < formals->stxs.size(); i++) {
+        SymbolSyntax* sym = dynamic_cast<SymbolSyntax*>(formals->stxs[i].get());
+        if (!sym) {
+            throw RuntimeError("Formals must be symbols");
+        }
+        if (sym->s == ".") {
+            SymbolSyntax* tail = i + 2 == formals->stxs.size()
+                ? dynamic_cast<SymbolSyntax*>(formals->stxs[i + 1].get()) : nullptr;
+            if (!tail) {
+                throw RuntimeError("Invalid rest parameter");
+            }
+            rest = tail->s;
+            return;
+        }
+        fixed.push_back(sym->s);
+    }
+}
+
+/**
+ * @brief Whether a body may refer to a name
+ * A macro use counts, since its expansion is not known yet.
+ */
+static bool mentions(const Syntax &stx, const string &name) {
+    if (SymbolSyntax* sym = dynamic_cast<SymbolSyntax*>(stx.get())) {
+        return sym->s == name;
+    }
+    List* l = dynamic_cast<List*>(stx.get());
+    if (!l) {
+        return false;
+    }
+    if (!l->stxs.empty()) {
+        SymbolSyntax* head = dynamic_cast<SymbolSyntax*>(l->stxs[0].get());
+        if (head && isMacro(head->s)) {
+            return true;
+        }
+    }
+    for (auto &s : l->stxs) {
+        if (mentions(s, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Give a body a frame of its own unless it cannot define anything
+ */
+static Expr scoped(const Syntax &body, const Expr &e) {
+    if (mentions(body, "define") || mentions(body, "define-record-type")) {
+        return Expr(new Scope(e));
+    }
+    return e;
+}
+
+/**
+ * @brief Build the Lambda for formals and a body
+ * The rest list is only built at call time if the body refers to it. A call
+ * that binds nothing runs in the closure environment, so internal defines
+ * need a Scope there.
+ */
+static Expr makeLambda(const vector<string> &fixed, const string &rest, const Syntax &body, Assoc &env) {
+    vector<string> names = fixed;
+    if (!rest.empty()) {
+        names.push_back(rest);
+    }
+    Assoc body_env = bindLocals(names, env);
+    Expr e = body->parse(body_env);
+    bool used = !rest.empty() && mentions(body, rest);
+    if (fixed.empty() && !used) {
+        e = scoped(body, e);
+    }
+    if (rest.empty()) {
+        return Expr(new Lambda(fixed, e));
+    }
+    return Expr(new Lambda(fixed, rest, used, e));
+}
+
+Value syntaxToValue(Syntax &, Assoc &);
+
+/**
+ * @brief One element of a quasiquote template
+ *
+ * Constant parts carry their value, built once here; the rest carry the
+ * expression that computes them.
+ */
+struct QuasiPart {
+    Value datum;
+    Expr code;
+    bool splice;
+    QuasiPart(const Value &v) : datum(v), code(nullptr), splice(false) {}
+    QuasiPart(const Expr &e, bool spl) : datum(nullptr), code(e), splice(spl) {}
+};
+
+static Expr quasiExpr(const QuasiPart &part) {
+    return part.datum.get() != nullptr ? Expr(new Const(part.datum)) : part.code;
+}
+
+static bool isQuasiForm(List *l, const char *name) {
+    if (l == nullptr || l->stxs.size() != 2) {
+        return false;
+    }
+    SymbolSyntax *head = dynamic_cast<SymbolSyntax*>(l->stxs[0].get());
+    return head != nullptr && head->s == name;
+}
+
+static QuasiPart quasi(Syntax stx, int depth, Assoc &env);
+
+static QuasiPart quasiList(List *l, int depth, Assoc &env) {
+    size_t n = l->stxs.size();
+    int inner = depth;
+    if (isQuasiForm(l, "unquote") || isQuasiForm(l, "unquote-splicing")) {
+        inner = depth - 1;
+    } else if (isQuasiForm(l, "quasiquote")) {
+        inner = depth + 1;
+    }
+
+    QuasiPart tail(NullV());
+    size_t end = n;
+    SymbolSyntax *dot = n >= 3 ? dynamic_cast<SymbolSyntax*>(l->stxs[n - 2].get()) : nullptr;
+    if (dot != nullptr && dot->s == ".") {
+        tail = quasi(l->stxs[n - 1], depth, env);
+        end = n - 2;
+    }
+
+    vector<QuasiPart> parts;
+    for (size_t i = 0; i < end; i++) {
+        int d = i == 1 ? inner : depth;
+        List *elem = dynamic_cast<List*>(l->stxs[i].get());
+        if (d == 1 && isQuasiForm(elem, "unquote-splicing")) {
+            parts.push_back(QuasiPart(elem->stxs[1]->parse(env), true));
+        } else {
+            parts.push_back(quasi(l->stxs[i], d, env));
+        }
+    }
+
+    // The longest constant suffix becomes one shared pre-built list
+    size_t k = parts.size();
+    Value acc = tail.datum;
+    if (acc.get() != nullptr) {
+        while (k > 0 && parts[k - 1].datum.get() != nullptr) {
+            acc = PairV(parts[k - 1].datum, acc);
+            k--;
+        }
+        if (k == 0) {
+            return QuasiPart(acc);
+        }
+    }
+    Expr rest = acc.get() != nullptr ? Expr(new Const(acc)) : tail.code;
+    bool rest_null = acc.get() != nullptr && acc->v_type == V_NULL;
+
+    // Runs of elements become one list (or a chain of conses onto a
+    // non-empty tail); spliced lists are appended in front of the rest
+    while (k > 0) {
+        if (parts[k - 1].splice) {
+            Expr spliced = parts[k - 1].code;
+            rest = rest_null ? spliced : Expr(new Append({spliced, rest}));
+            rest_null = false;
+            k--;
+            continue;
+        }
+        size_t start = k;
+        while (start > 0 && !parts[start - 1].splice) {
+            start--;
+        }
+        if (rest_null) {
+            vector<Expr> elems;
+            for (size_t i = start; i < k; i++) {
+                elems.push_back(quasiExpr(parts[i]));
+            }
+            rest = Expr(new ListFunc(elems));
+        } else {
+            for (size_t i = k; i-- > start;) {
+                rest = Expr(new Cons(quasiExpr(parts[i]), rest));
+            }
+        }
+        rest_null = false;
+        k = start;
+    }
+    return QuasiPart(rest, false);
+}
+
+static QuasiPart quasi(Syntax stx, int depth, Assoc &env) {
+    List *l = dynamic_cast<List*>(stx.get());
+    if (l == nullptr) {
+        return QuasiPart(syntaxToValue(stx, env));
+    }
+    if (isQuasiForm(l, "unquote") && depth == 1) {
+        return QuasiPart(l->stxs[1]->parse(env), false);
+    }
+    if (isQuasiForm(l, "unquote-splicing") && depth == 1) {
+        throw RuntimeError("unquote-splicing must appear inside a list");
+    }
+    return quasiList(l, depth, env);
+}
+
+// `else` opens a catch-all clause unless a local binding shadows it
+static bool isElse(const Syntax &stx, Assoc &env) {
+    SymbolSyntax *sym = dynamic_cast<SymbolSyntax*>(stx.get());
+    return sym != nullptr && sym->s == "else" && find("else", env).get() == nullptr;
+}
+
+static const int MAX_EXPANSION_DEPTH = 10000;
+static thread_local int expansion_depth = 0;
+
+struct ExpansionGuard {
+    ExpansionGuard() {
+        if (++expansion_depth > MAX_EXPANSION_DEPTH) {
+            expansion_depth--;
+            throw RuntimeError("Macro expansion too deep");
+        }
+    }
+    ~ExpansionGuard() { expansion_depth--; }
+};
+
 /**
  * @brief Default parse method (should be overridden by subclasses)
  */
@@ -47,6 +292,10 @@ Expr StringSyntax::parse(Assoc &env) {
     return Expr(new StringExpr(s));
 }
 
+Expr CharSyntax::parse(Assoc &env) {
+    return Expr(new Const(CharV(c)));
+}
+
 Expr TrueSyntax::parse(Assoc &env) {
     return Expr(new True());
 }
@@ -83,6 +332,10 @@ Expr List::parse(Assoc &env) {
         }
         return Expr(new Apply(Expr(new Var(op)), rand));
     }
+    if (isMacro(op)) {
+        ExpansionGuard guard;
+        return expandMacro(op, this)->parse(env);
+    }
     if (primitives.count(op) != 0) {
         vector<Expr> parameters;
         //TODO: TO COMPLETE THE PARAMETER PARSER LOGIC
@@ -127,6 +380,8 @@ Expr List::parse(Assoc &env) {
             return Expr(new Expt(parameters[0], parameters[1]));
         } else if (op_type == E_LIST) {
             return Expr(new ListFunc(parameters));
+        } else if (op_type == E_APPEND) {
+            return Expr(new Append(parameters));
         } else if (op_type == E_LT) {
             if (parameters.size() == 2) {
                 return Expr(new Less(parameters[0], parameters[1]));
@@ -236,11 +491,366 @@ Expr List::parse(Assoc &env) {
                 throw RuntimeError("Wrong number of arguments for set-cdr!");
             }
             return Expr(new SetCdr(parameters[0], parameters[1]));
-        } else if (op_type == E_DISPLAY) {
+        } else if (op_type == E_MAKE_PROMISE) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for make-promise");
+            }
+            return Expr(new MakePromise(parameters[0]));
+        } else if (op_type == E_FORCE) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for force");
+            }
+            return Expr(new Force(parameters[0]));
+        } else if (op_type == E_PROMISEQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for promise?");
+            }
+            return Expr(new IsPromise(parameters[0]));
+        } else if (op_type == E_CALLCC) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for " + op);
+            }
+            return Expr(new CallCC(parameters[0]));
+        } else if (op_type == E_DYNAMIC_WIND) {
+            if (parameters.size() != 3) {
+                throw RuntimeError("Wrong number of arguments for dynamic-wind");
+            }
+            return Expr(new DynamicWind(parameters));
+        } else if (op_type == E_RAISE || op_type == E_RAISE_CONTINUABLE) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for " + op);
+            }
+            return Expr(new Raise(op_type, parameters[0]));
+        } else if (op_type == E_WITH_HANDLER) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for with-exception-handler");
+            }
+            return Expr(new WithHandler(parameters[0], parameters[1]));
+        } else if (op_type == E_ERROR) {
+            return Expr(new MakeError(parameters));
+        } else if (op_type == E_ERRORQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for error-object?");
+            }
+            return Expr(new IsError(parameters[0]));
+        } else if (op_type == E_ERROR_MESSAGE) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for error-object-message");
+            }
+            return Expr(new ErrorMessage(parameters[0]));
+        } else if (op_type == E_ERROR_IRRITANTS) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for error-object-irritants");
+            }
+            return Expr(new ErrorIrritants(parameters[0]));
+        } else if (op_type == E_FUTURE) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for future");
+            }
+            return Expr(new FutureFunc(parameters[0]));
+        } else if (op_type == E_TOUCH) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for touch");
+            }
+            return Expr(new Touch(parameters[0]));
+        } else if (op_type == E_PMAP) {
+            if (parameters.size() < 2) {
+                throw RuntimeError("Wrong number of arguments for pmap");
+            }
+            return Expr(new PMap(parameters));
+        } else if (op_type == E_PARALLEL_FOR) {
+            if (parameters.size() != 3) {
+                throw RuntimeError("Wrong number of arguments for parallel-for");
+            }
+            return Expr(new ParallelFor(parameters));
+        } else if (op_type == E_VALUES) {
+            return Expr(new Values(parameters));
+        } else if (op_type == E_CALL_WITH_VALUES) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for call-with-values");
+            }
+            return Expr(new CallWithValues(parameters[0], parameters[1]));
+        } else if (op_type == E_STRING_APPEND) {
+            return Expr(new StringAppend(parameters));
+        } else if (op_type == E_SUBSTRING) {
+            return Expr(new Substring(parameters));
+        } else if (op_type == E_STRING_LENGTH) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for string-length");
+            }
+            return Expr(new StringLength(parameters[0]));
+        } else if (op_type == E_STRING_REF) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for string-ref");
+            }
+            return Expr(new StringRef(parameters[0], parameters[1]));
+        } else if (op_type == E_STRING_TO_SYMBOL) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for string->symbol");
+            }
+            return Expr(new StringToSymbol(parameters[0]));
+        } else if (op_type == E_SYMBOL_TO_STRING) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for symbol->string");
+            }
+            return Expr(new SymbolToString(parameters[0]));
+        } else if (op_type == E_NUMBER_TO_STRING) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for number->string");
+            }
+            return Expr(new NumberToString(parameters[0]));
+        } else if (op_type == E_STRING_TO_LIST) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for string->list");
+            }
+            return Expr(new StringToList(parameters[0]));
+        } else if (op_type == E_LIST_TO_STRING) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for list->string");
+            }
+            return Expr(new ListToString(parameters[0]));
+        } else if (op_type == E_MAKE_BYTEVECTOR) {
+            if (parameters.size() != 1 && parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for make-bytevector");
+            }
+            return Expr(new MakeBytevector(parameters));
+        } else if (op_type == E_BYTEVECTOR) {
+            return Expr(new BytevectorFunc(parameters));
+        } else if (op_type == E_BYTEVECTORQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for bytevector?");
+            }
+            return Expr(new IsBytevector(parameters[0]));
+        } else if (op_type == E_BYTEVECTOR_LENGTH) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for bytevector-length");
+            }
+            return Expr(new BytevectorLength(parameters[0]));
+        } else if (op_type == E_BYTEVECTOR_REF) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for bytevector-u8-ref");
+            }
+            return Expr(new BytevectorRef(parameters[0], parameters[1]));
+        } else if (op_type == E_BYTEVECTOR_SET) {
+            if (parameters.size() != 3) {
+                throw RuntimeError("Wrong number of arguments for bytevector-u8-set!");
+            }
+            return Expr(new BytevectorSet(parameters));
+        } else if (op_type == E_BYTEVECTOR_COPY) {
+            if (parameters.size() < 3 || parameters.size() > 5) {
+                throw RuntimeError("Wrong number of arguments for bytevector-copy!");
+            }
+            return Expr(new BytevectorCopy(parameters));
+        } else if (op_type == E_BYTEVECTOR_FILL) {
+            if (parameters.size() < 2 || parameters.size() > 4) {
+                throw RuntimeError("Wrong number of arguments for bytevector-fill!");
+            }
+            return Expr(new BytevectorFill(parameters));
+        } else if (op_type == E_MAKE_VECTOR) {
+            if (parameters.size() != 1 && parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for make-vector");
+            }
+            return Expr(new MakeVector(parameters));
+        } else if (op_type == E_VECTOR) {
+            return Expr(new VectorFunc(parameters));
+        } else if (op_type == E_VECTORQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for vector?");
+            }
+            return Expr(new IsVector(parameters[0]));
+        } else if (op_type == E_VECTOR_LENGTH) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for vector-length");
+            }
+            return Expr(new VectorLength(parameters[0]));
+        } else if (op_type == E_VECTOR_REF) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for vector-ref");
+            }
+            return Expr(new VectorRef(parameters[0], parameters[1]));
+        } else if (op_type == E_VECTOR_SET) {
+            if (parameters.size() != 3) {
+                throw RuntimeError("Wrong number of arguments for vector-set!");
+            }
+            return Expr(new VectorSet(parameters));
+        } else if (op_type == E_VECTOR_TO_LIST) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for vector->list");
+            }
+            return Expr(new VectorToList(parameters[0]));
+        } else if (op_type == E_LIST_TO_VECTOR) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for list->vector");
+            }
+            return Expr(new ListToVector(parameters[0]));
+        } else if (op_type == E_VECTOR_SUM) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for vector-sum");
+            }
+            return Expr(new VectorSum(parameters[0]));
+        } else if (op_type == E_VECTOR_DOT) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for vector-dot");
+            }
+            return Expr(new VectorDot(parameters[0], parameters[1]));
+        } else if (op_type == E_VECTOR_MAX) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for vector-max");
+            }
+            return Expr(new VectorMax(parameters[0]));
+        } else if (op_type == E_VECTOR_ADD) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for vector+");
+            }
+            return Expr(new VectorAdd(parameters[0], parameters[1]));
+        } else if (op_type == E_VECTOR_MAP) {
+            if (parameters.size() < 2) {
+                throw RuntimeError("Wrong number of arguments for vector-map");
+            }
+            return Expr(new VectorMap(parameters));
+        } else if (op_type == E_MAKE_EQ_HASHTABLE || op_type == E_MAKE_WEAK_EQ_HASHTABLE) {
+            if (parameters.size() != 0) {
+                throw RuntimeError("Wrong number of arguments for " + op);
+            }
+            return Expr(new MakeHashtable(op_type));
+        } else if (op_type == E_HASHTABLEQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for hashtable?");
+            }
+            return Expr(new IsHashtable(parameters[0]));
+        } else if (op_type == E_HASHTABLE_SIZE) {
             if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for hashtable-size");
+            }
+            return Expr(new HashtableSize(parameters[0]));
+        } else if (op_type == E_HASHTABLE_REF) {
+            if (parameters.size() != 3) {
+                throw RuntimeError("Wrong number of arguments for hashtable-ref");
+            }
+            return Expr(new HashtableRef(parameters));
+        } else if (op_type == E_HASHTABLE_SET) {
+            if (parameters.size() != 3) {
+                throw RuntimeError("Wrong number of arguments for hashtable-set!");
+            }
+            return Expr(new HashtableSet(parameters));
+        } else if (op_type == E_HASHTABLE_CONTAINS) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for hashtable-contains?");
+            }
+            return Expr(new HashtableContains(parameters[0], parameters[1]));
+        } else if (op_type == E_HASHTABLE_DELETE) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for hashtable-delete!");
+            }
+            return Expr(new HashtableDelete(parameters[0], parameters[1]));
+        } else if (op_type == E_HASHTABLE_KEYS) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for hashtable-keys");
+            }
+            return Expr(new HashtableKeys(parameters[0]));
+        } else if (op_type == E_HASHTABLE_CLEAR) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for hashtable-clear!");
+            }
+            return Expr(new HashtableClear(parameters[0]));
+        } else if (op_type == E_CHARQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for char?");
+            }
+            return Expr(new IsChar(parameters[0]));
+        } else if (op_type == E_CHAR_TO_INTEGER) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for char->integer");
+            }
+            return Expr(new CharToInteger(parameters[0]));
+        } else if (op_type == E_INTEGER_TO_CHAR) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for integer->char");
+            }
+            return Expr(new IntegerToChar(parameters[0]));
+        } else if (op_type == E_CHAR_EQ) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for char=?");
+            }
+            return Expr(new CharEq(parameters[0], parameters[1]));
+        } else if (op_type == E_CHAR_LT) {
+            if (parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for char<?");
+            }
+            return Expr(new CharLess(parameters[0], parameters[1]));
+        } else if (op_type == E_APPLY_PROC) {
+            return Expr(new ApplyProc(parameters));
+        } else if (op_type == E_DISPLAY) {
+            if (parameters.size() != 1 && parameters.size() != 2) {
                 throw RuntimeError("Wrong number of arguments for display");
             }
-            return Expr(new Display(parameters[0]));
+            return Expr(new Display(parameters));
+        } else if (op_type == E_WRITE) {
+            if (parameters.size() != 1 && parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for write");
+            }
+            return Expr(new Write(parameters));
+        } else if (op_type == E_WRITE_STRING) {
+            if (parameters.size() != 1 && parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for write-string");
+            }
+            return Expr(new WriteString(parameters));
+        } else if (op_type == E_WRITE_CHAR) {
+            if (parameters.size() != 1 && parameters.size() != 2) {
+                throw RuntimeError("Wrong number of arguments for write-char");
+            }
+            return Expr(new WriteChar(parameters));
+        } else if (op_type == E_NEWLINE) {
+            if (parameters.size() > 1) {
+                throw RuntimeError("Wrong number of arguments for newline");
+            }
+            return Expr(new Newline(parameters));
+        } else if (op_type == E_OPEN_OUTPUT_STRING) {
+            if (parameters.size() != 0) {
+                throw RuntimeError("Wrong number of arguments for open-output-string");
+            }
+            return Expr(new OpenOutputString());
+        } else if (op_type == E_GET_OUTPUT_STRING) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for get-output-string");
+            }
+            return Expr(new GetOutputString(parameters[0]));
+        } else if (op_type == E_READ_LINE || op_type == E_READ_CHAR || op_type == E_PEEK_CHAR ||
+                   op_type == E_READ || op_type == E_STDIN_LINES) {
+            if (parameters.size() != 0) {
+                throw RuntimeError("Wrong number of arguments for " + op);
+            }
+            return Expr(new ReadInput(op_type));
+        } else if (op_type == E_EOF_OBJECT) {
+            if (parameters.size() != 0) {
+                throw RuntimeError("Wrong number of arguments for eof-object");
+            }
+            return Expr(new EofObject());
+        } else if (op_type == E_EOF_OBJECTQ) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for eof-object?");
+            }
+            return Expr(new IsEofObject(parameters[0]));
+        } else if (op_type == E_GC || op_type == E_GC_STATS || op_type == E_HEAP_STATS) {
+            if (parameters.size() != 0) {
+                throw RuntimeError("Wrong number of arguments for " + op);
+            }
+            return Expr(new GcControl(op_type));
+        } else if (op_type == E_HEAP_LIMIT) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for heap-limit!");
+            }
+            return Expr(new HeapLimit(parameters[0]));
+        } else if (op_type == E_DUMP_HEAP) {
+            if (parameters.size() != 1) {
+                throw RuntimeError("Wrong number of arguments for dump-heap");
+            }
+            return Expr(new DumpHeap(parameters[0]));
+        } else if (op_type == E_CURRENT_OUTPUT_PORT) {
+            if (parameters.size() != 0) {
+                throw RuntimeError("Wrong number of arguments for current-output-port");
+            }
+            return Expr(new CurrentOutputPort());
         } else if (op_type == E_VOID) {
             if (parameters.size() != 0) {
                 throw RuntimeError("Wrong number of arguments for (void)");
@@ -264,6 +874,12 @@ Expr List::parse(Assoc &env) {
                 }
                 return Expr(new Quote(stxs[1]));
             }
+            case E_QUASIQUOTE: {
+                if (stxs.size() != 2) {
+                    throw RuntimeError("Wrong number of arguments for quasiquote");
+                }
+                return quasiExpr(quasi(stxs[1], 1, env));
+            }
             case E_BEGIN: {
                 vector<Expr> es;
                 for (size_t i = 1; i < stxs.size(); i++) {
@@ -286,29 +902,116 @@ Expr List::parse(Assoc &env) {
                     }
                     vector<Expr> clauseExprs;
                     for (auto& s : clauseList->stxs) {
-                        clauseExprs.push_back(s->parse(env));
+                        clauseExprs.push_back(isElse(s, env) ? Expr(new True()) : s->parse(env));
                     }
                     clauses.push_back(clauseExprs);
                 }
                 return Expr(new Cond(clauses));
             }
+            case E_CASE: {
+                if (stxs.size() < 2) {
+                    throw RuntimeError("Wrong number of arguments for case");
+                }
+                Case *dispatch = new Case(stxs[1]->parse(env));
+                Expr result(dispatch);
+                for (size_t i = 2; i < stxs.size(); i++) {
+                    List* clauseList = dynamic_cast<List*>(stxs[i].get());
+                    if (!clauseList || clauseList->stxs.empty()) {
+                        throw RuntimeError("Case clause must be a non-empty list");
+                    }
+                    int clause = dispatch->bodies.size();
+                    vector<Expr> body;
+                    for (size_t j = 1; j < clauseList->stxs.size(); j++) {
+                        body.push_back(clauseList->stxs[j]->parse(env));
+                    }
+                    dispatch->bodies.push_back(body.size() == 1 ? body[0] : Expr(new Begin(body)));
+
+                    if (isElse(clauseList->stxs[0], env)) {
+                        if (dispatch->else_clause < 0) {
+                            dispatch->else_clause = clause;
+                        }
+                        continue;
+                    }
+                    List* data = dynamic_cast<List*>(clauseList->stxs[0].get());
+                    if (!data) {
+                        throw RuntimeError("Case data must be a list");
+                    }
+                    for (auto& d : data->stxs) {
+                        if (Number* num = dynamic_cast<Number*>(d.get())) {
+                            dispatch->addFixnum(num->n, clause);
+                        } else if (SymbolSyntax* sym = dynamic_cast<SymbolSyntax*>(d.get())) {
+                            dispatch->addSymbol(sym->s, clause);
+                        } else if (CharSyntax* ch = dynamic_cast<CharSyntax*>(d.get())) {
+                            dispatch->addChar(ch->c, clause);
+                        } else if (dynamic_cast<TrueSyntax*>(d.get())) {
+                            if (dispatch->bool_clause[1] < 0) dispatch->bool_clause[1] = clause;
+                        } else if (dynamic_cast<FalseSyntax*>(d.get())) {
+                            if (dispatch->bool_clause[0] < 0) dispatch->bool_clause[0] = clause;
+                        } else if (List* l = dynamic_cast<List*>(d.get())) {
+                            if (l->stxs.empty() && dispatch->null_clause < 0) dispatch->null_clause = clause;
+                        }
+                        // Other data are never eqv? to a runtime value
+                    }
+                }
+                dispatch->buildJumpTable();
+                return result;
+            }
             case E_LAMBDA: {
                 if (stxs.size() != 3) {
                     throw RuntimeError("Wrong number of arguments for lambda");
                 }
-                List* paramsList = dynamic_cast<List*>(stxs[1].get());
-                if (!paramsList) {
-                    throw RuntimeError("Lambda parameters must be a list");
-                }
                 vector<string> params;
-                for (auto& s : paramsList->stxs) {
-                    SymbolSyntax* sym = dynamic_cast<SymbolSyntax*>(s.get());
-                    if (!sym) {
-                        throw RuntimeError("Lambda parameters must be symbols");
+                string rest;
+                parseFormals(stxs[1], 0, params, rest);
+                return makeLambda(params, rest, stxs[2], env);
+            }
+            case E_CASE_LAMBDA: {
+                // Clause k serves n arguments if it is the first to accept n
+                vector<Expr> clauses;
+                vector<int> by_arity;
+                int tail = -1;
+                size_t tail_arity = 0;
+                for (size_t i = 1; i < stxs.size(); i++) {
+                    List* clause = dynamic_cast<List*>(stxs[i].get());
+                    if (!clause || clause->stxs.size() < 2) {
+                        throw RuntimeError("Invalid case-lambda clause");
+                    }
+                    vector<string> params;
+                    string rest;
+                    parseFormals(clause->stxs[0], 0, params, rest);
+                    Syntax body = clause->stxs[1];
+                    if (clause->stxs.size() > 2) {
+                        List* seq = new List();
+                        seq->stxs.push_back(Syntax(new SymbolSyntax("begin")));
+                        seq->stxs.insert(seq->stxs.end(), clause->stxs.begin() + 1, clause->stxs.end());
+                        body = Syntax(seq);
+                    }
+                    int k = clauses.size();
+                    clauses.push_back(makeLambda(params, rest, body, env));
+                    size_t n = params.size();
+                    if (tail >= 0 && n >= tail_arity) {
+                        continue;   // an earlier rest clause accepts all of these
+                    }
+                    if (by_arity.size() <= n) {
+                        by_arity.resize(n + 1, -1);
+                    }
+                    if (rest.empty()) {
+                        if (by_arity[n] < 0) {
+                            by_arity[n] = k;
+                        }
+                    } else {
+                        for (size_t j = n; j < by_arity.size(); j++) {
+                            if (by_arity[j] < 0) {
+                                by_arity[j] = k;
+                            }
+                        }
+                        if (tail < 0) {
+                            tail = k;
+                            tail_arity = n;
+                        }
                     }
-                    params.push_back(sym->s);
                 }
-                return Expr(new Lambda(params, stxs[2]->parse(env)));
+                return Expr(new CaseLambda(clauses, by_arity, tail));
             }
             case E_DEFINE: {
                 if (stxs.size() != 3) {
@@ -329,15 +1032,9 @@ Expr List::parse(Assoc &env) {
                         throw RuntimeError("Function name must be a symbol");
                     }
                     vector<string> params;
-                    for (size_t i = 1; i < defList->stxs.size(); i++) {
-                        SymbolSyntax* param = dynamic_cast<SymbolSyntax*>(defList->stxs[i].get());
-                        if (!param) {
-                            throw RuntimeError("Parameters must be symbols");
-                        }
-                        params.push_back(param->s);
-                    }
-                    Expr lambda = Expr(new Lambda(params, stxs[2]->parse(env)));
-                    return Expr(new Define(funcName->s, lambda));
+                    string rest;
+                    parseFormals(stxs[1], 1, params, rest);
+                    return Expr(new Define(funcName->s, makeLambda(params, rest, stxs[2], env)));
                 }
             }
             case E_LET: {
@@ -349,6 +1046,7 @@ Expr List::parse(Assoc &env) {
                     throw RuntimeError("Let bindings must be a list");
                 }
                 vector<pair<string, Expr>> bindings;
+                vector<string> names;
                 for (auto& s : bindingsList->stxs) {
                     List* binding = dynamic_cast<List*>(s.get());
                     if (!binding || binding->stxs.size() != 2) {
@@ -359,8 +1057,14 @@ Expr List::parse(Assoc &env) {
                         throw RuntimeError("Binding variable must be a symbol");
                     }
                     bindings.push_back({var->s, binding->stxs[1]->parse(env)});
+                    names.push_back(var->s);
+                }
+                Assoc body_env = bindLocals(names, env);
+                Expr body = stxs[2]->parse(body_env);
+                if (bindings.empty()) {
+                    body = scoped(stxs[2], body);
                 }
-                return Expr(new Let(bindings, stxs[2]->parse(env)));
+                return Expr(new Let(bindings, body));
             }
             case E_LETREC: {
                 if (stxs.size() != 3) {
@@ -370,7 +1074,7 @@ Expr List::parse(Assoc &env) {
                 if (!bindingsList) {
                     throw RuntimeError("Letrec bindings must be a list");
                 }
-                vector<pair<string, Expr>> bindings;
+                vector<string> names;
                 for (auto& s : bindingsList->stxs) {
                     List* binding = dynamic_cast<List*>(s.get());
                     if (!binding || binding->stxs.size() != 2) {
@@ -380,9 +1084,15 @@ Expr List::parse(Assoc &env) {
                     if (!var) {
                         throw RuntimeError("Binding variable must be a symbol");
                     }
-                    bindings.push_back({var->s, binding->stxs[1]->parse(env)});
+                    names.push_back(var->s);
                 }
-                return Expr(new Letrec(bindings, stxs[2]->parse(env)));
+                Assoc body_env = bindLocals(names, env);
+                vector<pair<string, Expr>> bindings;
+                for (size_t i = 0; i < names.size(); i++) {
+                    List* binding = dynamic_cast<List*>(bindingsList->stxs[i].get());
+                    bindings.push_back({names[i], binding->stxs[1]->parse(body_env)});
+                }
+                return Expr(new Letrec(bindings, stxs[2]->parse(body_env)));
             }
             case E_SET: {
                 if (stxs.size() != 3) {
@@ -393,6 +1103,179 @@ Expr List::parse(Assoc &env) {
                     throw RuntimeError("Set! variable must be a symbol");
                 }
                 return Expr(new Set(varSym->s, stxs[2]->parse(env)));
+            }
+            case E_DEFINE_RECORD: {
+                // (define-record-type name (ctor field ...) pred (field accessor [modifier]) ...)
+                if (stxs.size() < 4) {
+                    throw RuntimeError("Wrong number of arguments for define-record-type");
+                }
+                SymbolSyntax* typeName = dynamic_cast<SymbolSyntax*>(stxs[1].get());
+                SymbolSyntax* predName = dynamic_cast<SymbolSyntax*>(stxs[3].get());
+                List* ctorSpec = dynamic_cast<List*>(stxs[2].get());
+                if (!typeName || !predName || !ctorSpec || ctorSpec->stxs.empty()) {
+                    throw RuntimeError("Invalid define-record-type syntax");
+                }
+                vector<string> fields;
+                vector<List*> fieldSpecs;
+                for (size_t i = 4; i < stxs.size(); i++) {
+                    List* spec = dynamic_cast<List*>(stxs[i].get());
+                    SymbolSyntax* field = spec && !spec->stxs.empty() ?
+                        dynamic_cast<SymbolSyntax*>(spec->stxs[0].get()) : nullptr;
+                    if (!field || spec->stxs.size() > 3) {
+                        throw RuntimeError("Invalid record field spec");
+                    }
+                    fields.push_back(field->s);
+                    fieldSpecs.push_back(spec);
+                }
+                std::shared_ptr<RecordType> type(new RecordType(typeName->s, fields));
+
+                vector<Expr> defs;
+                SymbolSyntax* ctorName = dynamic_cast<SymbolSyntax*>(ctorSpec->stxs[0].get());
+                if (!ctorName) {
+                    throw RuntimeError("Record constructor name must be a symbol");
+                }
+                vector<string> params;
+                vector<int> slots;
+                vector<Expr> args;
+                for (size_t i = 1; i < ctorSpec->stxs.size(); i++) {
+                    SymbolSyntax* arg = dynamic_cast<SymbolSyntax*>(ctorSpec->stxs[i].get());
+                    size_t slot = 0;
+                    while (arg && slot < fields.size() && fields[slot] != arg->s) {
+                        slot++;
+                    }
+                    if (!arg || slot == fields.size()) {
+                        throw RuntimeError("Record constructor argument is not a field");
+                    }
+                    params.push_back(arg->s);
+                    slots.push_back(slot);
+                    args.push_back(Expr(new Var(arg->s)));
+                }
+                defs.push_back(Expr(new Define(ctorName->s,
+                    Expr(new Lambda(params, Expr(new RecordMake(type, slots, args)))))));
+                defs.push_back(Expr(new Define(predName->s,
+                    Expr(new Lambda({"obj"}, Expr(new RecordIs(type, Expr(new Var("obj")))))))));
+                for (size_t i = 0; i < fieldSpecs.size(); i++) {
+                    List* spec = fieldSpecs[i];
+                    for (size_t j = 1; j < spec->stxs.size(); j++) {
+                        SymbolSyntax* procName = dynamic_cast<SymbolSyntax*>(spec->stxs[j].get());
+                        if (!procName) {
+                            throw RuntimeError("Record accessor name must be a symbol");
+                        }
+                        Expr body = j == 1 ?
+                            Expr(new RecordRef(type, i, Expr(new Var("record")))) :
+                            Expr(new RecordSet(type, i, Expr(new Var("record")), Expr(new Var("value"))));
+                        vector<string> procParams = {"record"};
+                        if (j == 2) {
+                            procParams.push_back("value");
+                        }
+                        defs.push_back(Expr(new Define(procName->s, Expr(new Lambda(procParams, body)))));
+                    }
+                }
+                defs.push_back(Expr(new MakeVoid()));
+                return Expr(new Begin(defs));
+            }
+            case E_DELAY:
+            case E_DELAY_FORCE: {
+                if (stxs.size() != 2) {
+                    throw RuntimeError("Wrong number of arguments for " + op);
+                }
+                return Expr(new Delay(reserved_words[op], stxs[1]->parse(env)));
+            }
+            case E_GUARD: {
+                // (guard (var clause ...) body ...)
+                List* spec = stxs.size() >= 3 ? dynamic_cast<List*>(stxs[1].get()) : nullptr;
+                SymbolSyntax* var = spec && !spec->stxs.empty() ?
+                    dynamic_cast<SymbolSyntax*>(spec->stxs[0].get()) : nullptr;
+                if (!var) {
+                    throw RuntimeError("Invalid guard syntax");
+                }
+                vector<Expr> body;
+                for (size_t i = 2; i < stxs.size(); i++) {
+                    body.push_back(stxs[i]->parse(env));
+                }
+                Assoc clause_env = bindLocals({var->s}, env);
+                vector<vector<Expr>> clauses;
+                bool has_else = false;
+                for (size_t i = 1; i < spec->stxs.size(); i++) {
+                    List* clauseList = dynamic_cast<List*>(spec->stxs[i].get());
+                    if (!clauseList || clauseList->stxs.empty()) {
+                        throw RuntimeError("Guard clause must be a non-empty list");
+                    }
+                    vector<Expr> clauseExprs;
+                    for (auto& s : clauseList->stxs) {
+                        bool else_test = clauseExprs.empty() && isElse(s, clause_env);
+                        has_else = has_else || else_test;
+                        clauseExprs.push_back(else_test ? Expr(new True()) : s->parse(clause_env));
+                    }
+                    clauses.push_back(clauseExprs);
+                }
+                if (!has_else) {
+                    // No clause applies: pass the object on to the next handler out
+                    clauses.push_back({Expr(new True()), Expr(new Raise(E_RAISE, Expr(new Var(var->s))))});
+                }
+                return Expr(new Guard(var->s, body.size() == 1 ? body[0] : Expr(new Begin(body)),
+                                      Expr(new Cond(clauses))));
+            }
+            case E_LET_VALUES: {
+                // (let-values ((formals expr) ...) body ...) or (receive formals expr body ...)
+                vector<Syntax> specs;
+                size_t body_at = 2;
+                if (op == "receive") {
+                    if (stxs.size() < 4) {
+                        throw RuntimeError("Wrong number of arguments for receive");
+                    }
+                    List* spec = new List();
+                    spec->stxs.push_back(stxs[1]);
+                    spec->stxs.push_back(stxs[2]);
+                    specs.push_back(Syntax(spec));
+                    body_at = 3;
+                } else {
+                    List* bindingsList = stxs.size() >= 3 ? dynamic_cast<List*>(stxs[1].get()) : nullptr;
+                    if (!bindingsList) {
+                        throw RuntimeError("Invalid let-values syntax");
+                    }
+                    specs = bindingsList->stxs;
+                }
+                vector<vector<string>> formals;
+                vector<string> rests;
+                vector<Expr> inits;
+                vector<string> names;
+                for (auto& s : specs) {
+                    List* binding = dynamic_cast<List*>(s.get());
+                    if (!binding || binding->stxs.size() != 2) {
+                        throw RuntimeError("Each binding must be a list of 2 elements");
+                    }
+                    vector<string> fixed;
+                    string rest;
+                    parseFormals(binding->stxs[0], 0, fixed, rest);
+                    names.insert(names.end(), fixed.begin(), fixed.end());
+                    if (!rest.empty()) {
+                        names.push_back(rest);
+                    }
+                    formals.push_back(fixed);
+                    rests.push_back(rest);
+                    inits.push_back(binding->stxs[1]->parse(env));
+                }
+                Assoc body_env = bindLocals(names, env);
+                vector<Expr> body;
+                for (size_t i = body_at; i < stxs.size(); i++) {
+                    body.push_back(stxs[i]->parse(body_env));
+                }
+                if (body.empty()) {
+                    throw RuntimeError("Missing body for " + op);
+                }
+                return Expr(new LetValues(formals, rests, inits, body.size() == 1 ? body[0] : Expr(new Begin(body))));
+            }
+            case E_DEFINE_SYNTAX: {
+                if (stxs.size() != 3) {
+                    throw RuntimeError("Wrong number of arguments for define-syntax");
+                }
+                SymbolSyntax* name = dynamic_cast<SymbolSyntax*>(stxs[1].get());
+                if (!name) {
+                    throw RuntimeError("Macro name must be a symbol");
+                }
+                defineSyntax(name->s, stxs[2]);
+                return Expr(new MakeVoid());
             }
 			default:
             	throw RuntimeError("Unknown reserved word: " + op);
@@ -0,0 +1,205 @@
+/**
+ * @file pool.cpp
+ * @brief Work-stealing thread pool
+ */
+
+#include "pool.hpp"
+#include "gc.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+Task::Task(const std::function<Value()> &b) : body(b), done(false), result(nullptr) {}
+
+void Task::run() {
+    try {
+        result = body();
+        if (result->v_type == V_VALUES) {
+            // The values register belongs to this thread; keep them with the task
+            takeValues(result, values);
+        }
+    } catch (...) {
+        error = std::current_exception();
+    }
+    done.store(true, std::memory_order_release);
+}
+
+namespace {
+
+// Tasks submitted and not yet finished, including what they left to release
+std::atomic<long> in_flight(0);
+
+struct Worker {
+    std::mutex m;
+    std::deque<std::shared_ptr<Task>> tasks;
+};
+
+class WorkPool {
+public:
+    WorkPool() : queued(0), next(0), stop(false) {
+        size_t n = std::thread::hardware_concurrency();
+        if (const char *env = std::getenv("SCHEME_THREADS")) {
+            n = std::max(1, std::atoi(env));
+        }
+        // The thread waiting on a task also runs tasks, so one fewer worker
+        n = n > 1 ? n - 1 : 1;
+        workers.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            workers.emplace_back(new Worker());
+        }
+        for (size_t i = 0; i < n; i++) {
+            threads.emplace_back([this, i] { loop(i); });
+        }
+    }
+
+    ~WorkPool() {
+        {
+            std::lock_guard<std::mutex> lock(idle_m);
+            stop = true;
+        }
+        idle_cv.notify_all();
+        for (auto &t : threads) {
+            t.join();
+        }
+    }
+
+    void submit(const std::shared_ptr<Task> &task) {
+        size_t at = self >= 0 ? (size_t)self : next++ % workers.size();
+        {
+            std::lock_guard<std::mutex> lock(workers[at]->m);
+            workers[at]->tasks.push_back(task);
+        }
+        queued++;
+        idle_cv.notify_one();
+    }
+
+    // Run one queued task: our own newest first, else the oldest of another
+    bool runOne() {
+        std::shared_ptr<Task> task;
+        if (self >= 0) {
+            Worker &own = *workers[self];
+            std::lock_guard<std::mutex> lock(own.m);
+            if (!own.tasks.empty()) {
+                task = own.tasks.back();
+                own.tasks.pop_back();
+            }
+        }
+        size_t start = self >= 0 ? (size_t)self + 1 : next.load();
+        for (size_t k = 0; !task && k < workers.size(); k++) {
+            Worker &victim = *workers[(start + k) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.m);
+            if (!victim.tasks.empty()) {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task) {
+            return false;
+        }
+        queued--;
+        task->run();
+        task.reset();
+        in_flight.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void wait(const std::shared_ptr<Task> &task) {
+        while (!task->done.load(std::memory_order_acquire)) {
+            mergeBiasedCounts();
+            if (!runOne()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    size_t size() const {
+        return workers.size() + 1;
+    }
+
+    static bool onWorker() {
+        return self >= 0;
+    }
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::atomic<long> queued;
+    std::atomic<size_t> next;
+    std::mutex idle_m;
+    std::condition_variable idle_cv;
+    bool stop;
+    static thread_local int self;   ///< Index of the worker running here, -1 elsewhere
+
+    void loop(size_t i) {
+        self = (int)i;
+        while (true) {
+            mergeBiasedCounts();
+            if (runOne()) {
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(idle_m);
+            if (stop) {
+                return;
+            }
+            idle_cv.wait_for(lock, std::chrono::milliseconds(10), [this] { return stop || queued > 0; });
+        }
+    }
+};
+
+thread_local int WorkPool::self = -1;
+
+WorkPool &pool() {
+    static WorkPool instance;
+    return instance;
+}
+
+void enqueue(const std::shared_ptr<Task> &task) {
+    in_flight.fetch_add(1, std::memory_order_acq_rel);
+    pool().submit(task);
+}
+
+}
+
+void submitTask(const std::shared_ptr<Task> &task) {
+    // The collector counts references only while no other thread runs
+    gcFinishCycle();
+    enqueue(task);
+}
+
+void waitTask(const std::shared_ptr<Task> &task) {
+    pool().wait(task);
+    if (task->error) {
+        std::rethrow_exception(task->error);
+    }
+}
+
+void parallelInvoke(size_t n, const std::function<void(size_t)> &fn) {
+    std::vector<std::shared_ptr<Task>> tasks;
+    for (size_t i = 1; i < n; i++) {
+        tasks.push_back(std::make_shared<Task>([&fn, i] {
+            fn(i);
+            return VoidV();
+        }));
+        enqueue(tasks.back());
+    }
+    fn(0);
+    for (auto &task : tasks) {
+        waitTask(task);
+    }
+}
+
+size_t poolSize() {
+    return pool().size();
+}
+
+bool poolIdle() {
+    return in_flight.load(std::memory_order_acquire) == 0;
+}
+
+bool onPoolWorker() {
+    return WorkPool::onWorker();
+}
@@ -0,0 +1,65 @@
+#ifndef POOL_HPP
+#define POOL_HPP
+
+/**
+ * @file pool.hpp
+ * @brief Work-stealing thread pool behind future, pmap and parallel-for
+ *
+ * Each worker owns a deque: it pushes and pops its own tasks at the back and
+ * steals from the front of the others' deques when its own runs dry. A thread
+ * waiting for a task runs queued tasks instead of blocking, so tasks may wait
+ * on tasks they spawned without exhausting the workers. SCHEME_THREADS
+ * overrides the thread count.
+ */
+
+#include "value.hpp"
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+
+struct Task {
+    std::function<Value()> body;
+    std::atomic<bool> done;
+    Value result;
+    std::vector<Value> values;     ///< Set when body returned multiple values
+    std::exception_ptr error;
+    Task(const std::function<Value()> &);
+    void run();
+};
+
+/**
+ * @brief Queue a task on the pool
+ */
+void submitTask(const std::shared_ptr<Task> &);
+
+/**
+ * @brief Run queued tasks on this thread until the given one is done
+ * Rethrows whatever the task threw.
+ */
+void waitTask(const std::shared_ptr<Task> &);
+
+/**
+ * @brief Run fn(0) .. fn(n - 1) at once, fn(0) on this thread
+ * For runtime work that evaluates nothing: unlike submitTask it leaves a
+ * collection in progress alone.
+ */
+void parallelInvoke(size_t n, const std::function<void(size_t)> &fn);
+
+/**
+ * @brief Number of threads that run tasks, counting the one waiting
+ */
+size_t poolSize();
+
+/**
+ * @brief Whether no submitted task is queued or running
+ */
+bool poolIdle();
+
+/**
+ * @brief Whether this thread is one of the pool's workers
+ */
+bool onPoolWorker();
+
+#endif
@@ -0,0 +1,227 @@
+/**
+ * @file simd.cpp
+ * @brief Scalar, SSE4.1 and AVX2 versions of the fixnum vector kernels
+ *
+ * The vector versions are compiled with per-function target attributes, so
+ * the binary still runs on CPUs without them; intKernels() asks the CPU once
+ * which set to use.
+ */
+
+#include "simd.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#endif
+
+// Scalar kernels, computed on unsigned values so overflow wraps
+
+static int sumScalar(const int *a, size_t n) {
+    unsigned s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += (unsigned)a[i];
+    return (int)s;
+}
+
+static int dotScalar(const int *a, const int *b, size_t n) {
+    unsigned s = 0;
+    for (size_t i = 0; i < n; i++)
+        s += (unsigned)a[i] * (unsigned)b[i];
+    return (int)s;
+}
+
+static int maxScalar(const int *a, size_t n) {
+    int m = a[0];
+    for (size_t i = 1; i < n; i++)
+        if (a[i] > m)
+            m = a[i];
+    return m;
+}
+
+static void addScalar(const int *a, const int *b, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = (int)((unsigned)a[i] + (unsigned)b[i]);
+}
+
+static void subScalar(const int *a, const int *b, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = (int)((unsigned)a[i] - (unsigned)b[i]);
+}
+
+static void mulScalar(const int *a, const int *b, int *out, size_t n) {
+    for (size_t i = 0; i < n; i++)
+        out[i] = (int)((unsigned)a[i] * (unsigned)b[i]);
+}
+
+static const IntKernels scalar_kernels = {
+    "scalar", sumScalar, dotScalar, maxScalar, addScalar, subScalar, mulScalar
+};
+
+#ifdef HAVE_X86_KERNELS
+
+// SSE4.1: four lanes
+
+__attribute__((target("sse4.1")))
+static int hsum128(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(v);
+}
+
+__attribute__((target("sse4.1")))
+static int sumSse(const int *a, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        acc = _mm_add_epi32(acc, _mm_loadu_si128((const __m128i *)(a + i)));
+    return (int)((unsigned)hsum128(acc) + (unsigned)sumScalar(a + i, n - i));
+}
+
+__attribute__((target("sse4.1")))
+static int dotSse(const int *a, const int *b, size_t n) {
+    __m128i acc = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        acc = _mm_add_epi32(acc, _mm_mullo_epi32(x, y));
+    }
+    return (int)((unsigned)hsum128(acc) + (unsigned)dotScalar(a + i, b + i, n - i));
+}
+
+__attribute__((target("sse4.1")))
+static int maxSse(const int *a, size_t n) {
+    if (n < 4)
+        return maxScalar(a, n);
+    __m128i m = _mm_loadu_si128((const __m128i *)a);
+    size_t i = 4;
+    for (; i + 4 <= n; i += 4)
+        m = _mm_max_epi32(m, _mm_loadu_si128((const __m128i *)(a + i)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(1, 0, 3, 2)));
+    m = _mm_max_epi32(m, _mm_shuffle_epi32(m, _MM_SHUFFLE(2, 3, 0, 1)));
+    int best = _mm_cvtsi128_si32(m);
+    for (; i < n; i++)
+        if (a[i] > best)
+            best = a[i];
+    return best;
+}
+
+__attribute__((target("sse4.1")))
+static void addSse(const int *a, const int *b, int *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i *)(out + i), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                             _mm_loadu_si128((const __m128i *)(b + i))));
+    addScalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+static void subSse(const int *a, const int *b, int *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i *)(out + i), _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                             _mm_loadu_si128((const __m128i *)(b + i))));
+    subScalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("sse4.1")))
+static void mulSse(const int *a, const int *b, int *out, size_t n) {
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4)
+        _mm_storeu_si128((__m128i *)(out + i), _mm_mullo_epi32(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                               _mm_loadu_si128((const __m128i *)(b + i))));
+    mulScalar(a + i, b + i, out + i, n - i);
+}
+
+static const IntKernels sse_kernels = {
+    "sse4.1", sumSse, dotSse, maxSse, addSse, subSse, mulSse
+};
+
+// AVX2: eight lanes
+
+__attribute__((target("avx2")))
+static __m128i fold256(__m256i v) {
+    return _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+__attribute__((target("avx2")))
+static int sumAvx(const int *a, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        acc = _mm256_add_epi32(acc, _mm256_loadu_si256((const __m256i *)(a + i)));
+    return (int)((unsigned)hsum128(fold256(acc)) + (unsigned)sumScalar(a + i, n - i));
+}
+
+__attribute__((target("avx2")))
+static int dotAvx(const int *a, const int *b, size_t n) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(x, y));
+    }
+    return (int)((unsigned)hsum128(fold256(acc)) + (unsigned)dotScalar(a + i, b + i, n - i));
+}
+
+__attribute__((target("avx2")))
+static int maxAvx(const int *a, size_t n) {
+    if (n < 8)
+        return maxSse(a, n);
+    __m256i m = _mm256_loadu_si256((const __m256i *)a);
+    size_t i = 8;
+    for (; i + 8 <= n; i += 8)
+        m = _mm256_max_epi32(m, _mm256_loadu_si256((const __m256i *)(a + i)));
+    int lanes[8];
+    _mm256_storeu_si256((__m256i *)lanes, m);
+    int best = maxScalar(lanes, 8);
+    for (; i < n; i++)
+        if (a[i] > best)
+            best = a[i];
+    return best;
+}
+
+__attribute__((target("avx2")))
+static void addAvx(const int *a, const int *b, int *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                                                   _mm256_loadu_si256((const __m256i *)(b + i))));
+    addScalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void subAvx(const int *a, const int *b, int *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_sub_epi32(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                                                   _mm256_loadu_si256((const __m256i *)(b + i))));
+    subScalar(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void mulAvx(const int *a, const int *b, int *out, size_t n) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_mullo_epi32(_mm256_loadu_si256((const __m256i *)(a + i)),
+                                                                     _mm256_loadu_si256((const __m256i *)(b + i))));
+    mulScalar(a + i, b + i, out + i, n - i);
+}
+
+static const IntKernels avx2_kernels = {
+    "avx2", sumAvx, dotAvx, maxAvx, addAvx, subAvx, mulAvx
+};
+
+#endif
+
+const IntKernels &intKernels() {
+#ifdef HAVE_X86_KERNELS
+    static const IntKernels &chosen = __builtin_cpu_supports("avx2") ? avx2_kernels
+                                    : __builtin_cpu_supports("sse4.1") ? sse_kernels
+                                    : scalar_kernels;
+    return chosen;
+#else
+    return scalar_kernels;
+#endif
+}
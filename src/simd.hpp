@@ -0,0 +1,28 @@
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+/**
+ * @file simd.hpp
+ * @brief Bulk kernels over unboxed fixnum arrays
+ *
+ * Arithmetic wraps around on overflow, like the interpreter's own fixnums.
+ */
+
+#include <cstddef>
+
+struct IntKernels {
+    const char *name;
+    int (*sum)(const int *, size_t);
+    int (*dot)(const int *, const int *, size_t);
+    int (*max)(const int *, size_t);                      ///< n must be positive
+    void (*add)(const int *, const int *, int *, size_t);
+    void (*sub)(const int *, const int *, int *, size_t);
+    void (*mul)(const int *, const int *, int *, size_t);
+};
+
+/**
+ * @brief The fastest kernels this CPU supports, chosen on first use
+ */
+const IntKernels &intKernels();
+
+#endif
@@ -35,6 +35,22 @@ void StringSyntax::show(std::ostream &os) {
     os << "\"" << s << "\"";
 }
 
+CharSyntax::CharSyntax(char ch) : c(ch) {}
+void CharSyntax::show(std::ostream &os) {
+    os << "#\\" << charName(c);
+}
+
+std::string charName(char c) {
+    switch (c) {
+        case ' ': return "space";
+        case '\n': return "newline";
+        case '\t': return "tab";
+        case '\r': return "return";
+        case '\0': return "null";
+        default: return std::string(1, c);
+    }
+}
+
 List::List() {}
 void List::show(std::ostream &os) {
     os << '(';
@@ -130,6 +146,39 @@ Syntax createIdentifierSyntax(const std::string &s) {
   return Syntax(new SymbolSyntax(s));
 }
 
+Syntax readItem(std::istream &is);
+
+static bool isDelimiter(int c) {
+  return c == '(' || c == ')' || c == '[' || c == ']' || c == ';' || isspace(c) || c == EOF;
+}
+
+// Read a character after #\ : one character, or a name such as space
+static Syntax readCharacter(std::istream &is) {
+  std::string name(1, (char)is.get());
+  while (!isDelimiter(is.peek()))
+    name.push_back(is.get());
+  if (name.size() == 1)
+    return Syntax(new CharSyntax(name[0]));
+  static const char *names[] = {"space", "newline", "tab", "return", "null"};
+  static const char chars[] = {' ', '\n', '\t', '\r', '\0'};
+  for (size_t i = 0; i < sizeof(chars); i++)
+    if (name == names[i])
+      return Syntax(new CharSyntax(chars[i]));
+  if (name[0] == 'x' && name.size() <= 3 && name.find_first_not_of("0123456789abcdefABCDEF", 1) == std::string::npos)
+    return Syntax(new CharSyntax((char)std::stoi(name.substr(1), nullptr, 16)));
+  // Unknown names read as a symbol, which fails when evaluated
+  return Syntax(new SymbolSyntax("#\\" + name));
+}
+
+// Read the element after ' ` , or ,@ and wrap it as (<name> <syntax>)
+Syntax readAbbreviation(std::istream &is, const char *name) {
+  Syntax quoted_syntax = readItem(is);
+  List *quote_list = new List();
+  quote_list->stxs.push_back(Syntax(new SymbolSyntax(name)));
+  quote_list->stxs.push_back(quoted_syntax);
+  return Syntax(quote_list);
+}
+
 // no leading space
 Syntax readItem(std::istream &is) {
   if (is.peek() == '(' || is.peek() == '[') {
@@ -139,15 +188,19 @@ Syntax readItem(std::istream &is) {
   if (is.peek() == '\'')
   {
     is.get();
-    // Read syntax element after single quote
-    Syntax quoted_syntax = readItem(is);
-    
-    // Create list structure for (quote <syntax>)
-    List *quote_list = new List();
-    quote_list->stxs.push_back(Syntax(new SymbolSyntax("quote")));
-    quote_list->stxs.push_back(quoted_syntax);
-    
-    return Syntax(quote_list);
+    return readAbbreviation(is, "quote");
+  }
+  if (is.peek() == '`') {
+    is.get();
+    return readAbbreviation(is, "quasiquote");
+  }
+  if (is.peek() == ',') {
+    is.get();
+    if (is.peek() == '@') {
+      is.get();
+      return readAbbreviation(is, "unquote-splicing");
+    }
+    return readAbbreviation(is, "unquote");
   }
   // Handle string literals
   if (is.peek() == '"') {
@@ -178,6 +231,14 @@ Syntax readItem(std::istream &is) {
   
   // Read token
   std::string s;
+  if (is.peek() == '#') {
+    is.get();
+    if (is.peek() == '\\') {
+      is.get();
+      return readCharacter(is);
+    }
+    s.push_back('#');
+  }
   do {
     int c = is.peek();
     if (c == '(' || c == ')' ||
@@ -4,6 +4,7 @@
 #include <cstring>
 #include <memory>
 #include <vector>
+#include <map>
 #include "Def.hpp"
 
 struct SyntaxBase {
@@ -62,6 +63,16 @@ struct StringSyntax : SyntaxBase {
     virtual void show(std::ostream &) override;
 };
 
+struct CharSyntax : SyntaxBase {
+    char c;
+    CharSyntax(char);
+    virtual Expr parse(Assoc &) override;
+    virtual void show(std::ostream &) override;
+};
+
+// The name written after #\ for a character, e.g. "space" or "a"
+std::string charName(char);
+
 struct List : SyntaxBase {
     std::vector<Syntax> stxs;
     List();
@@ -69,7 +80,20 @@ struct List : SyntaxBase {
     virtual void show(std::ostream &) override;
 };
 
+struct SyntaxRules {
+    std::vector<std::string> literals;
+    std::vector<std::pair<Syntax, Syntax>> rules;    // (pattern, template)
+    std::vector<std::vector<std::string>> binders;   // names each template binds itself
+    std::map<std::string, int> shape_cache;          // input shape -> matching rule, -1 if none
+    bool isLiteral(const std::string &) const;
+};
+
+void defineSyntax(const std::string &, const Syntax &);
+bool isMacro(const std::string &);
+Syntax expandMacro(const std::string &, List *);
+
 Syntax readSyntax(std::istream &);
+std::istream &readSpace(std::istream &);
 
 std::istream &operator>>(std::istream &, Syntax);
 #endif
\ No newline at end of file
@@ -7,12 +7,31 @@
  */
 
 #include "value.hpp"
+#include "gc.hpp"
+#include "RE.hpp"
+#include <algorithm>
+#include <mutex>
+#include <map>
+#include <string>
 
 // ============================================================================
 // Base ValueBase Implementation
 // ============================================================================
 
-ValueBase::ValueBase(ValueType vt) : v_type(vt) {}
+ValueBase::ValueBase(ValueType vt)
+    : v_type(vt), immortal(false), weak_key(false), immutable(false), biased(0), owner(currentThreadTag()), shared(0),
+      gc_color(GC_UNTRACKED), gc_slot(0), gc_refs(0) {}
+
+static void weakKeyDied(ValueBase *);
+
+ValueBase::~ValueBase() {
+    if (weak_key.load(std::memory_order_relaxed)) {
+        weakKeyDied(this);
+    }
+    if (gc_color.load(std::memory_order_relaxed) != GC_UNTRACKED) {
+        gcUntrack(this);
+    }
+}
 
 void ValueBase::showCdr(std::ostream &os) {
     os << " . ";
@@ -24,18 +43,138 @@ void ValueBase::showCdr(std::ostream &os) {
 // Value Smart Pointer Implementation
 // ============================================================================
 
-Value::Value(ValueBase *ptr) : ptr(ptr) {}
+static const int64_t MERGED = 1, QUEUED = 2;
 
-ValueBase* Value::operator->() const { 
-    return ptr.get(); 
+static std::atomic<uint32_t> next_thread_tag(1);
+
+uint32_t currentThreadTag() {
+    static thread_local uint32_t tag = next_thread_tag++;
+    return tag;
 }
 
-ValueBase& Value::operator*() { 
-    return *ptr; 
+// Values whose shared count went negative, waiting for their owner to merge
+static std::mutex merge_lock;
+static std::map<uint32_t, std::vector<ValueBase *>> merge_queues;
+static std::atomic<int> merge_pending(0);
+
+// Held while merging; the collector pauses merges under it
+static std::mutex merge_gate;
+static bool merges_paused = false;
+
+static void destroyValue(ValueBase *p) {
+    if (p->gc_color.load(std::memory_order_relaxed) != GC_UNTRACKED && !gcDying(p)) {
+        return;
+    }
+    delete p;
 }
 
-ValueBase* Value::get() const { 
-    return ptr.get(); 
+// The owner's last reference is gone: fold in the shared count for good
+void releaseOwned(ValueBase *p) {
+    p->owner.store(0, std::memory_order_relaxed);
+    int64_t old = p->shared.fetch_or(MERGED, std::memory_order_acq_rel);
+    if ((old >> 2) == 0 && !(old & QUEUED)) {
+        destroyValue(p);
+    }
+}
+
+void releaseShared(ValueBase *p) {
+    int64_t old = p->shared.fetch_sub(4, std::memory_order_acq_rel);
+    int64_t count = (old >> 2) - 1;
+    if (old & QUEUED) {
+        return;  // the owner's merge decides
+    }
+    if (old & MERGED) {
+        if (count == 0) {
+            destroyValue(p);
+        }
+        return;
+    }
+    if (count < 0 && !(p->shared.fetch_or(QUEUED, std::memory_order_acq_rel) & QUEUED)) {
+        uint32_t owner = p->owner.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(merge_lock);
+        merge_queues[owner].push_back(p);
+        merge_pending++;
+    }
+}
+
+static void mergeQueued(const std::vector<ValueBase *> &queued) {
+    for (ValueBase *p : queued) {
+        if (p->owner.load(std::memory_order_relaxed) != 0) {
+            int64_t add = ((int64_t)p->biased << 2) | MERGED;
+            p->biased = 0;
+            p->owner.store(0, std::memory_order_relaxed);
+            p->shared.fetch_add(add, std::memory_order_acq_rel);
+        }
+        int64_t old = p->shared.fetch_and(~QUEUED, std::memory_order_acq_rel);
+        if ((old >> 2) == 0) {
+            destroyValue(p);
+        }
+    }
+}
+
+void mergeBiasedCounts() {
+    if (merge_pending.load(std::memory_order_relaxed) == 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> gate(merge_gate);
+    if (merges_paused) {
+        return;
+    }
+    std::vector<ValueBase *> mine;
+    {
+        std::lock_guard<std::mutex> lock(merge_lock);
+        auto it = merge_queues.find(currentThreadTag());
+        if (it == merge_queues.end()) {
+            return;
+        }
+        mine.swap(it->second);
+        merge_pending -= (int)mine.size();
+    }
+    mergeQueued(mine);
+}
+
+void mergeAllBiasedCounts() {
+    std::lock_guard<std::mutex> gate(merge_gate);
+    while (merge_pending.load() > 0) {
+        std::vector<ValueBase *> queued;
+        {
+            std::lock_guard<std::mutex> lock(merge_lock);
+            for (auto &q : merge_queues) {
+                queued.insert(queued.end(), q.second.begin(), q.second.end());
+                q.second.clear();
+            }
+            merge_pending -= (int)queued.size();
+        }
+        mergeQueued(queued);
+    }
+}
+
+void pauseBiasedMerges(bool paused) {
+    std::lock_guard<std::mutex> gate(merge_gate);
+    merges_paused = paused;
+}
+
+int64_t referenceCount(const ValueBase *p) {
+    if (p->immortal) {
+        return INT64_MAX / 2;
+    }
+    int64_t count = p->shared.load(std::memory_order_acquire) >> 2;
+    if (p->owner.load(std::memory_order_acquire) != 0) {
+        count += p->biased;
+    }
+    return count;
+}
+
+ValueBase *immortalize(const Value &v) {
+    v->immortal = true;
+    return v.get();
+}
+
+void freezePairs(const Value &v) {
+    for (ValueBase *p = v.get(); p->v_type == V_PAIR; p = static_cast<Pair*>(p)->cdr.get()) {
+        p->immutable = true;
+        freezePairs(static_cast<Pair*>(p)->car);
+    }
 }
 
 void Value::show(std::ostream &os) {
@@ -47,20 +186,36 @@ void Value::show(std::ostream &os) {
 // ============================================================================
 
 AssocList::AssocList(const std::string &x, const Value &v, Assoc &next)
-    : x(x), v(v), next(next) {}
+    : ValueBase(V_FRAME), x(x), v(v), next(next) {
+    gcTrack(this);
+}
+
+void AssocList::show(std::ostream &os) {
+    os << "#<environment>";
+}
+
+void AssocList::traverse(GcVisitor &visit) {
+    visit(v);
+    visit(next);
+}
+
+void AssocList::clearRefs() {
+    v = Value(nullptr);
+    next = Assoc(nullptr);
+}
 
 Assoc::Assoc(AssocList *x) : ptr(x) {}
 
 AssocList* Assoc::operator->() const { 
-    return ptr.get(); 
+    return static_cast<AssocList*>(ptr.get()); 
 }
 
 AssocList& Assoc::operator*() { 
-    return *ptr; 
+    return *static_cast<AssocList*>(ptr.get()); 
 }
 
 AssocList* Assoc::get() const { 
-    return ptr.get(); 
+    return static_cast<AssocList*>(ptr.get()); 
 }
 
 Assoc empty() {
@@ -71,9 +226,25 @@ Assoc extend(const std::string &x, const Value &v, Assoc &lst) {
     return Assoc(new AssocList(x, v, lst));
 }
 
+// Add a binding that everything already sharing the chain can see: it goes
+// right behind the head, or becomes the head of an empty environment
+void insert(const std::string &x, const Value &v, Assoc &lst) {
+    if (lst.get() == nullptr) {
+        lst = extend(x, v, lst);
+    } else if (lst->x == x) {
+        gcWriteBarrier(lst->v);
+        lst->v = v;
+    } else {
+        gcWriteBarrier(lst->next);
+        lst->next = extend(x, v, lst->next);
+    }
+}
+
+// The chain is held by lst, so walk it without counting each frame
 void modify(const std::string &x, const Value &v, Assoc &lst) {
-    for (auto i = lst; i.get() != nullptr; i = i->next) {
+    for (AssocList *i = lst.get(); i != nullptr; i = i->next.get()) {
         if (x == i->x) {
+            gcWriteBarrier(i->v);
             i->v = v;
             return;
         }
@@ -81,7 +252,7 @@ void modify(const std::string &x, const Value &v, Assoc &lst) {
 }
 
 Value find(const std::string &x, Assoc &l) {
-    for (auto i = l; i.get() != nullptr; i = i->next) {
+    for (AssocList *i = l.get(); i != nullptr; i = i->next.get()) {
         if (x == i->x) {
             return i->v;
         }
@@ -101,7 +272,8 @@ void Void::show(std::ostream &os) {
 }
 
 Value VoidV() {
-    return Value(new Void());
+    static ValueBase *unit = immortalize(Value(new Void()));
+    return Value(unit);
 }
 
 // Integer
@@ -165,7 +337,9 @@ void Boolean::show(std::ostream &os) {
 }
 
 Value BooleanV(bool b) {
-    return Value(new Boolean(b));
+    static ValueBase *t = immortalize(Value(new Boolean(true)));
+    static ValueBase *f = immortalize(Value(new Boolean(false)));
+    return Value(b ? t : f);
 }
 
 // Symbol
@@ -175,21 +349,283 @@ void Symbol::show(std::ostream &os) {
     os << s;
 }
 
+// Symbols are interned and immortal, so threads share them without counting
 Value SymbolV(const std::string &s) {
-    return Value(new Symbol(s));
+    static std::mutex lock;
+    static std::map<std::string, ValueBase *> interned;
+    std::lock_guard<std::mutex> guard(lock);
+    ValueBase *&sym = interned[s];
+    if (sym == nullptr) {
+        sym = immortalize(Value(new Symbol(s)));
+    }
+    return Value(sym);
+}
+
+// Char
+Char::Char(char ch) : ValueBase(V_CHAR), c(ch) {}
+
+void Char::show(std::ostream &os) {
+    os << "#\\" << charName(c);
+}
+
+Value CharV(char c) {
+    static std::vector<ValueBase *> chars = [] {
+        std::vector<ValueBase *> all;
+        for (int i = 0; i < 256; i++) {
+            all.push_back(immortalize(Value(new Char((char)i))));
+        }
+        return all;
+    }();
+    return Value(chars[(unsigned char)c]);
+}
+
+// Counted against the heap cap before the storage is allocated
+static size_t reserved(size_t n, size_t size) {
+    heapReserve(n * size);
+    return n;
+}
+
+// Bytevector
+Bytevector::Bytevector(size_t n, unsigned char fill) : ValueBase(V_BYTEVECTOR), bytes(reserved(n, 1), fill) {}
+
+Bytevector::~Bytevector() {
+    heapUnreserve(bytes.size());
+}
+
+void Bytevector::show(std::ostream &os) {
+    os << "#u8(";
+    for (size_t i = 0; i < bytes.size(); i++) {
+        if (i > 0) {
+            os << ' ';
+        }
+        os << (int)bytes[i];
+    }
+    os << ')';
+}
+
+Value BytevectorV(size_t n, unsigned char fill) {
+    return Value(new Bytevector(n, fill));
+}
+
+// Vector
+Vector::Vector(std::vector<int> &&ns) : ValueBase(V_VECTOR), packed(true), ints(std::move(ns)) {
+    heapReserve(storage());
+    gcTrack(this);
+}
+
+Vector::Vector(std::vector<Value> &&vs) : ValueBase(V_VECTOR), packed(false), items(std::move(vs)) {
+    heapReserve(storage());
+    gcTrack(this);
+}
+
+Vector::Vector(size_t n, int fill) : ValueBase(V_VECTOR), packed(true), ints(reserved(n, sizeof(int)), fill) {
+    gcTrack(this);
+}
+
+Vector::Vector(size_t n, const Value &fill)
+    : ValueBase(V_VECTOR), packed(false), items(reserved(n, sizeof(Value)), fill) {
+    gcTrack(this);
+}
+
+Vector::~Vector() {
+    heapUnreserve(storage());
+}
+
+void Vector::traverse(GcVisitor &visit) {
+    for (const Value &item : items) {
+        visit(item);
+    }
+}
+
+void Vector::clearRefs() {
+    heapUnreserve(storage());
+    std::vector<Value>().swap(items);
+    std::vector<int>().swap(ints);
+    packed = true;
+}
+
+size_t Vector::size() const {
+    return packed ? ints.size() : items.size();
+}
+
+size_t Vector::storage() const {
+    return packed ? ints.size() * sizeof(int) : items.size() * sizeof(Value);
+}
+
+Value Vector::ref(size_t i) const {
+    return packed ? IntegerV(ints[i]) : items[i];
+}
+
+void Vector::set(size_t i, const Value &v) {
+    if (!packed) {
+        gcWriteBarrier(items[i]);
+        items[i] = v;
+        return;
+    }
+    if (v->v_type == V_INT) {
+        ints[i] = static_cast<Integer*>(v.get())->n;
+        return;
+    }
+    heapReserve(ints.size() * sizeof(Value));
+    items.reserve(ints.size());
+    for (int n : ints) {
+        items.push_back(IntegerV(n));
+    }
+    heapUnreserve(ints.size() * sizeof(int));
+    std::vector<int>().swap(ints);
+    packed = false;
+    items[i] = v;
+}
+
+void Vector::show(std::ostream &os) {
+    os << "#(";
+    for (size_t i = 0; i < size(); i++) {
+        if (i > 0) {
+            os << ' ';
+        }
+        if (packed) {
+            os << ints[i];
+        } else {
+            items[i]->show(os);
+        }
+    }
+    os << ')';
+}
+
+// Pack the elements if they are all fixnums
+Value VectorV(std::vector<Value> &&vs) {
+    for (auto &v : vs) {
+        if (v->v_type != V_INT) {
+            return Value(new Vector(std::move(vs)));
+        }
+    }
+    std::vector<int> ns;
+    ns.reserve(vs.size());
+    for (auto &v : vs) {
+        ns.push_back(static_cast<Integer*>(v.get())->n);
+    }
+    return Value(new Vector(std::move(ns)));
+}
+
+Value VectorV(std::vector<int> &&ns) {
+    return Value(new Vector(std::move(ns)));
+}
+
+Value VectorV(size_t n, const Value &fill) {
+    if (fill->v_type == V_INT) {
+        return Value(new Vector(n, static_cast<Integer*>(fill.get())->n));
+    }
+    return Value(new Vector(n, fill));
 }
 
 // String
-String::String(const std::string &s) : ValueBase(V_STRING), s(s) {}
+Text::Text(const std::string &s)
+    : data(s), left_off(0), left_len(0), right_off(0), right_len(0), length(s.size()), flat(true) {
+    heapReserve(data.size());
+}
+
+Text::Text(const std::shared_ptr<Text> &l, size_t loff, size_t llen,
+           const std::shared_ptr<Text> &r, size_t roff, size_t rlen)
+    : left(l), right(r), left_off(loff), left_len(llen), right_off(roff), right_len(rlen),
+      length(llen + rlen), flat(false) {}
+
+Text::~Text() {
+    heapUnreserve(data.size());
+    // Release long chains of rope nodes without recursing
+    std::vector<std::shared_ptr<Text>> pending;
+    if (left) pending.push_back(std::move(left));
+    if (right) pending.push_back(std::move(right));
+    while (!pending.empty()) {
+        std::shared_ptr<Text> t = std::move(pending.back());
+        pending.pop_back();
+        if (t.use_count() == 1) {
+            if (t->left) pending.push_back(std::move(t->left));
+            if (t->right) pending.push_back(std::move(t->right));
+        }
+    }
+}
+
+const std::string &Text::chars() {
+    if (flat.load(std::memory_order_acquire)) {
+        return data;
+    }
+    // Strings may be read from several threads; one of them flattens
+    static std::mutex flatten_lock;
+    std::lock_guard<std::mutex> lock(flatten_lock);
+    if (flat.load(std::memory_order_relaxed)) {
+        return data;
+    }
+    // Appends in a loop build ropes as deep as they are long, so walk the
+    // pieces with an explicit stack rather than recursing.
+    heapReserve(length);
+    std::string out;
+    out.reserve(length);
+    std::vector<std::pair<Text *, std::pair<size_t, size_t>>> todo;
+    todo.push_back({this, {0, length}});
+    while (!todo.empty()) {
+        Text *t = todo.back().first;
+        size_t off = todo.back().second.first, len = todo.back().second.second;
+        todo.pop_back();
+        if (!t->left) {
+            out.append(t->data, off, len);
+            continue;
+        }
+        // Slice [off, off + len) of the left piece followed by the right one
+        size_t lend = std::min(off + len, t->left_len);
+        if (off + len > t->left_len) {
+            size_t roff = off > t->left_len ? off - t->left_len : 0;
+            todo.push_back({t->right.get(), {t->right_off + roff, off + len - t->left_len - roff}});
+        }
+        if (off < lend) {
+            todo.push_back({t->left.get(), {t->left_off + off, lend - off}});
+        }
+    }
+    data.swap(out);
+    left.reset();
+    right.reset();
+    flat.store(true, std::memory_order_release);
+    return data;
+}
+
+String::String(const std::string &s)
+    : ValueBase(V_STRING), text(std::make_shared<Text>(s)), offset(0), length(s.size()) {}
+
+String::String(const std::shared_ptr<Text> &t, size_t off, size_t len)
+    : ValueBase(V_STRING), text(t), offset(off), length(len) {}
+
+std::string String::str() const {
+    return text->chars().substr(offset, length);
+}
+
+char String::at(size_t i) const {
+    return text->chars()[offset + i];
+}
 
 void String::show(std::ostream &os) {
-    os << "\"" << s << "\"";
+    os << "\"";
+    os.write(text->chars().data() + offset, length);
+    os << "\"";
 }
 
 Value StringV(const std::string &s) {
     return Value(new String(s));
 }
 
+Value SubstringV(const String &s, size_t start, size_t len) {
+    return Value(new String(s.text, s.offset + start, len));
+}
+
+Value StringAppendV(const String &a, const String &b) {
+    // Short results are cheaper copied than linked
+    if (a.length + b.length <= 32) {
+        std::string joined = a.str();
+        joined += b.str();
+        return StringV(joined);
+    }
+    std::shared_ptr<Text> rope = std::make_shared<Text>(a.text, a.offset, a.length, b.text, b.offset, b.length);
+    return Value(new String(rope, 0, rope->length));
+}
+
 // ============================================================================
 // Special Value Types Implementation
 // ============================================================================
@@ -206,7 +642,8 @@ void Null::showCdr(std::ostream &os) {
 }
 
 Value NullV() {
-    return Value(new Null());
+    static ValueBase *null = immortalize(Value(new Null()));
+    return Value(null);
 }
 
 // Terminate
@@ -226,7 +663,19 @@ Value TerminateV() {
 
 // Pair
 Pair::Pair(const Value &car, const Value &cdr) 
-    : ValueBase(V_PAIR), car(car), cdr(cdr) {}
+    : ValueBase(V_PAIR), car(car), cdr(cdr) {
+    gcTrack(this);
+}
+
+void Pair::traverse(GcVisitor &visit) {
+    visit(car);
+    visit(cdr);
+}
+
+void Pair::clearRefs() {
+    car = Value(nullptr);
+    cdr = Value(nullptr);
+}
 
 void Pair::show(std::ostream &os) {
     os << '(' << car;
@@ -244,7 +693,29 @@ Value PairV(const Value &car, const Value &cdr) {
 
 // Procedure
 Procedure::Procedure(const std::vector<std::string> &xs, const Expr &e, const Assoc &env)
-    : ValueBase(V_PROC), parameters(xs), e(e), env(env) {}
+    : ValueBase(V_PROC), parameters(xs), rest_used(false), e(e), env(env) {
+    gcTrack(this);
+}
+
+Procedure::Procedure(const std::vector<std::string> &xs, const std::string &r, bool used, const Expr &e, const Assoc &env)
+    : ValueBase(V_PROC), parameters(xs), rest(r), rest_used(used), e(e), env(env) {
+    gcTrack(this);
+}
+
+void Procedure::traverse(GcVisitor &visit) {
+    visit(env);
+    if (cases && (!visit.exact || cases.use_count() == 1)) {
+        for (const Value &clause : cases->by_arity) {
+            visit(clause);
+        }
+        visit(cases->tail);
+    }
+}
+
+void Procedure::clearRefs() {
+    env = Assoc(nullptr);
+    cases.reset();
+}
 
 void Procedure::show(std::ostream &os) {
     os << "#<procedure>";
@@ -254,6 +725,409 @@ Value ProcedureV(const std::vector<std::string> &xs, const Expr &e, const Assoc
     return Value(new Procedure(xs, e, env));
 }
 
+Value ProcedureV(const std::vector<std::string> &xs, const std::string &rest, bool used, const Expr &e, const Assoc &env) {
+    return Value(new Procedure(xs, rest, used, e, env));
+}
+
+Value CaseProcedureV(const std::shared_ptr<CaseTable> &cases, const Assoc &env) {
+    Procedure *p = new Procedure({}, Expr(nullptr), env);
+    p->cases = cases;
+    return Value(p);
+}
+
+// Continuation
+ContinuationState::ContinuationState() : active(true) {}
+
+ContinuationThrow::ContinuationThrow(const std::shared_ptr<ContinuationState> &target, const Value &v)
+    : target(target), v(v) {}
+
+// Promise
+PromiseBox::PromiseBox(bool lazy, const Value &v, const Expr &e, const Assoc &env)
+    : done(false), lazy(lazy), value(v), e(e), env(env) {}
+
+Promise::Promise(const std::shared_ptr<PromiseBox> &box) : ValueBase(V_PROMISE), box(box) {
+    gcTrack(this);
+}
+
+// delay-force chains share boxes, so a box only counts exactly when unshared
+void Promise::traverse(GcVisitor &visit) {
+    if (box && (!visit.exact || box.use_count() == 1)) {
+        visit(box->value);
+        visit(box->env);
+    }
+}
+
+void Promise::clearRefs() {
+    box.reset();
+}
+
+void Promise::show(std::ostream &os) {
+    os << "#<promise>";
+}
+
+Value PromiseV(const Expr &e, const Assoc &env, bool lazy) {
+    return Value(new Promise(std::make_shared<PromiseBox>(lazy, Value(nullptr), e, env)));
+}
+
+Value ReadyPromiseV(const Value &v) {
+    std::shared_ptr<PromiseBox> box = std::make_shared<PromiseBox>(false, v, Expr(nullptr), Assoc(nullptr));
+    box->done = true;
+    return Value(new Promise(box));
+}
+
+// R7RS iterative forcing: a delay-force step adopts the state of the promise
+// its body returned instead of forcing it recursively
+Value force(const Value &v) {
+    if (v->v_type != V_PROMISE) {
+        return v;
+    }
+    Promise *p = static_cast<Promise*>(v.get());
+    while (!p->box->done) {
+        std::shared_ptr<PromiseBox> box = p->box;
+        Expr e = box->e;
+        Assoc env = box->env;
+        Value result = e->eval(env);
+        if (box->done) {
+            break; // forced again while its body ran
+        }
+        if (!box->lazy) {
+            oneValue(result);
+            gcWriteBarrier(box->value);
+            gcWriteBarrier(box->env);
+            box->done = true;
+            box->value = result;
+            box->e = Expr(nullptr);
+            box->env = Assoc(nullptr);
+        } else {
+            if (result->v_type != V_PROMISE) {
+                throw RuntimeError("delay-force body must yield a promise");
+            }
+            Promise *next = static_cast<Promise*>(result.get());
+            std::shared_ptr<PromiseBox> next_box = next->box;
+            gcWriteBarrier(box->value);
+            gcWriteBarrier(box->env);
+            gcWriteBarrier(next_box->value);
+            gcWriteBarrier(next_box->env);
+            box->done = next_box->done;
+            box->lazy = next_box->lazy;
+            box->value = next_box->value;
+            box->e = next_box->e;
+            box->env = next_box->env;
+            next->box = box;
+        }
+    }
+    return p->box->value;
+}
+
+// Record
+RecordType::RecordType(const std::string &name, const std::vector<std::string> &fields)
+    : name(name), fields(fields) {}
+
+Record::Record(const std::shared_ptr<RecordType> &type)
+    : ValueBase(V_RECORD), type(type), slots(type->fields.size(), VoidV()) {
+    gcTrack(this);
+}
+
+void Record::traverse(GcVisitor &visit) {
+    for (const Value &slot : slots) {
+        visit(slot);
+    }
+}
+
+void Record::clearRefs() {
+    std::vector<Value>().swap(slots);
+}
+
+void Record::show(std::ostream &os) {
+    os << "#<" << type->name << ">";
+}
+
+Value RecordV(const std::shared_ptr<RecordType> &type) {
+    return Value(new Record(type));
+}
+
+// Hashtable
+
+// Booleans, symbols, the empty list and void are single values, so only
+// fixnums need comparing by value
+size_t EqHash::operator()(const ValueBase *p) const {
+    if (p->v_type == V_INT) {
+        return std::hash<int>()(static_cast<const Integer *>(p)->n);
+    }
+    return (size_t)((uintptr_t)p >> 4);
+}
+
+bool EqEqual::operator()(const ValueBase *a, const ValueBase *b) const {
+    if (a->v_type == V_INT && b->v_type == V_INT) {
+        return static_cast<const Integer *>(a)->n == static_cast<const Integer *>(b)->n;
+    }
+    return a == b;
+}
+
+// The weak tables holding each weak key. The lock also guards the entries
+// of every weak table: a key dies on whichever thread drops it last.
+static std::mutex weak_lock;
+static std::unordered_map<const ValueBase *, std::vector<Hashtable *>> weak_owners;
+
+static bool heldWeakly(const Hashtable *t, const ValueBase *key) {
+    return t->weak && key->v_type != V_INT && !key->immortal;
+}
+
+static void forgetWeakKey(Hashtable *t, const ValueBase *key) {
+    auto it = weak_owners.find(key);
+    if (it == weak_owners.end()) {
+        return;
+    }
+    std::vector<Hashtable *> &owners = it->second;
+    owners.erase(std::find(owners.begin(), owners.end(), t));
+    if (owners.empty()) {
+        weak_owners.erase(it);
+    }
+}
+
+static void weakKeyDied(ValueBase *key) {
+    // Released once the lock is gone: they may hold the last reference to
+    // other weak keys
+    std::vector<Value> dropped;
+    std::lock_guard<std::mutex> lock(weak_lock);
+    auto it = weak_owners.find(key);
+    if (it == weak_owners.end()) {
+        return;
+    }
+    for (Hashtable *t : it->second) {
+        auto entry = t->entries.find(key);
+        gcWriteBarrier(entry->second.value);
+        dropped.push_back(std::move(entry->second.value));
+        t->entries.erase(entry);
+    }
+    weak_owners.erase(it);
+}
+
+// Locks weak_lock for weak tables only
+struct WeakGuard {
+    std::unique_lock<std::mutex> lock;
+    WeakGuard(const Hashtable *t) : lock(weak_lock, std::defer_lock) {
+        if (t->weak) {
+            lock.lock();
+        }
+    }
+};
+
+Hashtable::Hashtable(bool weak) : ValueBase(V_HASHTABLE), weak(weak) {
+    gcTrack(this);
+}
+
+Hashtable::~Hashtable() {
+    clear();
+}
+
+Value Hashtable::ref(const Value &key) const {
+    WeakGuard guard(this);
+    auto it = entries.find(key.get());
+    return it != entries.end() ? it->second.value : Value(nullptr);
+}
+
+void Hashtable::set(const Value &key, const Value &value) {
+    Value old(nullptr);
+    WeakGuard guard(this);
+    auto it = entries.find(key.get());
+    if (it != entries.end()) {
+        gcWriteBarrier(it->second.value);
+        old = std::move(it->second.value);
+        it->second.value = value;
+        return;
+    }
+    Entry &entry = entries[key.get()];
+    entry.value = value;
+    if (heldWeakly(this, key.get())) {
+        key->weak_key = true;
+        weak_owners[key.get()].push_back(this);
+    } else {
+        entry.key = key;
+    }
+}
+
+bool Hashtable::remove(const Value &key) {
+    Entry old;
+    WeakGuard guard(this);
+    auto it = entries.find(key.get());
+    if (it == entries.end()) {
+        return false;
+    }
+    if (it->second.key.get() == nullptr) {
+        forgetWeakKey(this, it->first);
+    }
+    gcWriteBarrier(it->second.key);
+    gcWriteBarrier(it->second.value);
+    old = std::move(it->second);
+    entries.erase(it);
+    return true;
+}
+
+void Hashtable::clear() {
+    std::unordered_map<const ValueBase *, Entry, EqHash, EqEqual> old;
+    WeakGuard guard(this);
+    for (auto &entry : entries) {
+        if (entry.second.key.get() == nullptr) {
+            forgetWeakKey(this, entry.first);
+        }
+        gcWriteBarrier(entry.second.key);
+        gcWriteBarrier(entry.second.value);
+    }
+    old.swap(entries);
+}
+
+size_t Hashtable::size() const {
+    WeakGuard guard(this);
+    return entries.size();
+}
+
+std::vector<Value> Hashtable::keys() const {
+    WeakGuard guard(this);
+    std::vector<Value> keys;
+    keys.reserve(entries.size());
+    bool sweeping = gcSweeping();
+    for (auto &entry : entries) {
+        ValueBase *key = const_cast<ValueBase *>(entry.first);
+        if (entry.second.key.get() == nullptr) {
+            // Nothing the collector marks leads to a weak key: one still
+            // white in the sweep is garbage, and one handed out mid-cycle
+            // must be shaded like a reference the mutator took
+            if (sweeping && key->gc_color.load(std::memory_order_relaxed) == GC_WHITE) {
+                continue;
+            }
+            if (gc_barrier_on.load(std::memory_order_relaxed)) {
+                gcShade(key);
+            }
+        }
+        keys.push_back(Value(key));
+    }
+    return keys;
+}
+
+void Hashtable::show(std::ostream &os) {
+    os << (weak ? "#<weak-eq-hashtable>" : "#<eq-hashtable>");
+}
+
+void Hashtable::traverse(GcVisitor &visit) {
+    for (auto &entry : entries) {
+        visit(entry.second.key);
+        visit(entry.second.value);
+    }
+}
+
+void Hashtable::clearRefs() {
+    clear();
+}
+
+Value HashtableV(bool weak) {
+    return Value(new Hashtable(weak));
+}
+
+// Port
+Port::Port(std::ostream *out) : ValueBase(V_PORT), os(out) {}
+
+Port::Port() : ValueBase(V_PORT), buffer(std::make_shared<std::ostringstream>()) {
+    os = buffer.get();
+}
+
+void Port::show(std::ostream &os) {
+    os << "#<port>";
+}
+
+Value OutputStringPortV() {
+    return Value(new Port());
+}
+
+Value ConsolePortV() {
+    static ValueBase *console = immortalize(Value(new Port(&std::cout)));
+    return Value(console);
+}
+
+// Future
+Future::Future(const std::shared_ptr<Task> &t) : ValueBase(V_FUTURE), task(t) {}
+
+void Future::show(std::ostream &os) {
+    os << "#<future>";
+}
+
+Value FutureV(const std::shared_ptr<Task> &t) {
+    return Value(new Future(t));
+}
+
+// End of file
+EofValue::EofValue() : ValueBase(V_EOF) {}
+
+void EofValue::show(std::ostream &os) {
+    os << "#<eof>";
+}
+
+Value EofV() {
+    static ValueBase *eof = immortalize(Value(new EofValue()));
+    return Value(eof);
+}
+
+// Multiple values
+static thread_local std::vector<Value> values_register;
+
+MultipleValues::MultipleValues() : ValueBase(V_VALUES) {}
+
+void MultipleValues::show(std::ostream &os) {
+    for (size_t i = 0; i < values_register.size(); i++) {
+        if (i > 0) {
+            os << std::endl;
+        }
+        values_register[i]->show(os);
+    }
+}
+
+Value ValuesV(const std::vector<Value> &vals) {
+    static ValueBase *marker = immortalize(Value(new MultipleValues()));
+    if (vals.size() == 1) {
+        return vals[0];
+    }
+    values_register.assign(vals.begin(), vals.end());
+    return Value(marker);
+}
+
+// Append what an expression returned, one value or several, to out
+void takeValues(const Value &v, std::vector<Value> &out) {
+    if (v->v_type != V_VALUES) {
+        out.push_back(v);
+        return;
+    }
+    out.insert(out.end(), values_register.begin(), values_register.end());
+    values_register.clear();
+}
+
+void multipleValuesError() {
+    throw RuntimeError("Multiple values where one was expected");
+}
+
+// Error object
+ErrorObject::ErrorObject(const std::string &message, const Value &irritants)
+    : ValueBase(V_ERROR), message(message), irritants(irritants) {
+    gcTrack(this);
+}
+
+void ErrorObject::traverse(GcVisitor &visit) {
+    visit(irritants);
+}
+
+void ErrorObject::clearRefs() {
+    irritants = Value(nullptr);
+}
+
+void ErrorObject::show(std::ostream &os) {
+    os << "#<error>";
+}
+
+Value ErrorObjectV(const std::string &message, const Value &irritants) {
+    return Value(new ErrorObject(message, irritants));
+}
+
+SchemeRaise::SchemeRaise(const Value &payload) : payload(payload) {}
+
 // ============================================================================
 // Utility Functions Implementation
 // ============================================================================
@@ -11,9 +11,28 @@
 
 #include "Def.hpp"
 #include "expr.hpp"
+#include "heap.hpp"
 #include <memory>
 #include <cstring>
 #include <vector>
+#include <sstream>
+#include <unordered_map>
+#include <atomic>
+#include <cstdint>
+
+struct GcVisitor;
+
+/**
+ * @brief Collector state of a value (see gc.hpp)
+ */
+enum GcColor : uint8_t {
+    GC_UNTRACKED,   ///< Not a container
+    GC_BLACK,       ///< Survivor, or outside any cycle
+    GC_NEW,         ///< Allocated during the current cycle
+    GC_WHITE,       ///< In the cycle's snapshot, not yet reached
+    GC_GREY,        ///< Reached, fields not yet scanned
+    GC_PURPLE       ///< Dropped a reference but not the last: a possible cycle root
+};
 
 // ============================================================================
 // Base classes and smart pointer wrappers
@@ -21,36 +40,144 @@
 
 /**
  * @brief Base class for all values in the Scheme interpreter
+ *
+ * Values are reference counted with biased counts. The thread that made a
+ * value counts its own references in `biased` with plain arithmetic; other
+ * threads count theirs in the atomic `shared` word, where the count may go
+ * negative while the owner still holds references. When the owner drops to
+ * zero it merges the two and the value becomes an ordinary atomically counted
+ * one. A remote drop that leaves the shared count negative queues the value
+ * for its owner to merge at its next safe point (see mergeBiasedCounts).
+ *
+ * Immortal values (literals, interned symbols, shared singletons) are never
+ * counted or freed.
+ *
+ * Containers also carry the cycle collector's state (see gc.hpp) and report
+ * the references they hold through traverse.
  */
 struct ValueBase {
     ValueType v_type;
+    bool immortal;
+    std::atomic<bool> weak_key;       ///< Has been a key of a weak hashtable
+    bool immutable;                   ///< Pair of a shared literal; set-car! and set-cdr! refuse it
+    uint32_t biased;                  ///< References held by the owner thread
+    std::atomic<uint32_t> owner;      ///< Owning thread tag, 0 once merged
+    std::atomic<int64_t> shared;      ///< Other threads' count << 2 | QUEUED | MERGED
+    std::atomic<uint8_t> gc_color;    ///< GcColor, GC_UNTRACKED for non-containers
+    uint32_t gc_slot;                 ///< Index in the collector's slot table
+    std::atomic<int64_t> gc_refs;     ///< Count left after subtracting heap references
     ValueBase(ValueType);
+    static void *operator new(size_t size) { return heapAlloc(size); }
+    static void operator delete(void *p, size_t size) { heapFree(p, size); }
     virtual void show(std::ostream &) = 0;
     virtual void showCdr(std::ostream &);
-    virtual ~ValueBase() = default;
+    virtual void traverse(GcVisitor &) {}
+    virtual void clearRefs() {}       ///< Drop held references; only for garbage
+    virtual ~ValueBase();
 };
 
+uint32_t currentThreadTag();
+void releaseShared(ValueBase *);
+void releaseOwned(ValueBase *);
+void gcPossibleRoot(ValueBase *);
+extern bool gc_trial_deletion;   ///< Buffer possible cycle roots (SCHEME_GC_TRIAL)
+
+// Called by the owning thread at points where no value is half-handed-over
+void mergeBiasedCounts();
+
+/**
+ * @brief Total reference count of a value
+ * Only exact while no other thread is touching it.
+ */
+int64_t referenceCount(const ValueBase *);
+
+/**
+ * @brief Hold or release all merges, so the collector sees counts that stay put
+ */
+void pauseBiasedMerges(bool);
+
+/**
+ * @brief Merge every thread's queued values on this one
+ * Only while merges are paused and the other threads are idle.
+ */
+void mergeAllBiasedCounts();
+
+inline void retainValue(ValueBase *p) {
+    if (p == nullptr || p->immortal) {
+        return;
+    }
+    if (p->owner.load(std::memory_order_relaxed) == currentThreadTag()) {
+        p->biased++;
+    } else {
+        p->shared.fetch_add(4, std::memory_order_relaxed);
+    }
+}
+
+inline void releaseValue(ValueBase *p) {
+    if (p == nullptr || p->immortal) {
+        return;
+    }
+    if (p->owner.load(std::memory_order_relaxed) == currentThreadTag()) {
+        if (--p->biased == 0) {
+            releaseOwned(p);
+        } else if (gc_trial_deletion && p->gc_color.load(std::memory_order_relaxed) == GC_BLACK) {
+            gcPossibleRoot(p);
+        }
+    } else {
+        releaseShared(p);
+    }
+}
+
 /**
- * @brief Smart pointer wrapper for ValueBase objects
+ * @brief Counted reference to a ValueBase
  */
 struct Value {
-    std::shared_ptr<ValueBase> ptr;
-    Value(ValueBase *);
+    ValueBase *ptr;
+    Value(ValueBase *p) : ptr(p) { retainValue(p); }
+    Value(const Value &other) : ptr(other.ptr) { retainValue(ptr); }
+    Value(Value &&other) : ptr(other.ptr) { other.ptr = nullptr; }
+    ~Value() { releaseValue(ptr); }
+    Value &operator=(const Value &other) {
+        retainValue(other.ptr);
+        releaseValue(ptr);
+        ptr = other.ptr;
+        return *this;
+    }
+    Value &operator=(Value &&other) {
+        if (this != &other) {
+            releaseValue(ptr);
+            ptr = other.ptr;
+            other.ptr = nullptr;
+        }
+        return *this;
+    }
     void show(std::ostream &);
-    ValueBase* operator->() const;
-    ValueBase& operator*();
-    ValueBase* get() const;
+    ValueBase* operator->() const { return ptr; }
+    ValueBase& operator*() { return *ptr; }
+    ValueBase* get() const { return ptr; }
 };
 
+/**
+ * @brief Mark a value immortal and hand back the bare pointer
+ * Only for values no other thread has seen yet.
+ */
+ValueBase *immortalize(const Value &);
+
+/**
+ * @brief Mark every pair reachable through car and cdr immutable
+ * For literals built once and shared by every evaluation.
+ */
+void freezePairs(const Value &);
+
 // ============================================================================
 // Environment (Association Lists)
 // ============================================================================
 
 /**
- * @brief Smart pointer wrapper for AssocList (Environment)
+ * @brief Counted reference to an AssocList (Environment)
  */
 struct Assoc {
-    std::shared_ptr<AssocList> ptr;
+    Value ptr;
     Assoc(AssocList *);
     AssocList* operator->() const;
     AssocList& operator*();
@@ -59,17 +186,23 @@ struct Assoc {
 
 /**
  * @brief Association list node for variable bindings
+ * Frames are values so that the cycle collector sees closures and the
+ * environments they are stored in as one graph.
  */
-struct AssocList {
+struct AssocList : ValueBase {
     std::string x;      ///< Variable name
     Value v;            ///< Variable value
     Assoc next;         ///< Next binding in the chain
     AssocList(const std::string &, const Value &, Assoc &);
+    virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
 };
 
 // Environment operations
 Assoc empty();
 Assoc extend(const std::string&, const Value &, Assoc &);
+void insert(const std::string&, const Value &, Assoc &);
 void modify(const std::string&, const Value &, Assoc &);
 Value find(const std::string &, Assoc &);
 
@@ -127,15 +260,92 @@ struct Symbol : ValueBase {
 };
 Value SymbolV(const std::string &);
 
+/**
+ * @brief Character value
+ * All 256 characters are preallocated, so CharV never allocates and eq?
+ * compares characters by identity.
+ */
+struct Char : ValueBase {
+    char c;
+    Char(char);
+    virtual void show(std::ostream &) override;
+};
+Value CharV(char);
+
+/**
+ * @brief Bytevector value, a mutable run of bytes stored contiguously
+ */
+struct Bytevector : ValueBase {
+    std::vector<unsigned char> bytes;
+    Bytevector(size_t, unsigned char);
+    ~Bytevector();
+    virtual void show(std::ostream &) override;
+};
+Value BytevectorV(size_t, unsigned char);
+
+/**
+ * @brief Vector value
+ *
+ * While every element is a fixnum the vector is packed: the numbers sit
+ * unboxed in ints, where the bulk numeric primitives run SIMD kernels over
+ * them. Storing anything else unpacks it into items for good.
+ */
+struct Vector : ValueBase {
+    bool packed;
+    std::vector<int> ints;       ///< Elements while packed
+    std::vector<Value> items;    ///< Elements once unpacked
+    Vector(std::vector<int> &&);
+    Vector(std::vector<Value> &&);
+    Vector(size_t, int);
+    Vector(size_t, const Value &);
+    ~Vector();
+    size_t size() const;
+    size_t storage() const;      ///< Element bytes counted against the heap cap
+    Value ref(size_t) const;
+    void set(size_t, const Value &);
+    virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
+};
+Value VectorV(std::vector<int> &&);
+Value VectorV(std::vector<Value> &&);
+Value VectorV(size_t, const Value &);
+
+/**
+ * @brief Immutable character buffer shared between strings
+ *
+ * A leaf holds characters. A rope node joins two slices of other buffers and
+ * is flattened into a leaf the first time its characters are read, so a chain
+ * of appends costs time linear in the final length.
+ */
+struct Text {
+    std::string data;
+    std::shared_ptr<Text> left, right;     ///< Set on rope nodes only
+    size_t left_off, left_len, right_off, right_len;
+    size_t length;
+    std::atomic<bool> flat;                ///< Set once data holds every character
+    Text(const std::string &);
+    Text(const std::shared_ptr<Text> &, size_t, size_t, const std::shared_ptr<Text> &, size_t, size_t);
+    ~Text();
+    const std::string &chars();
+};
+
 /**
  * @brief String value
+ * A string is a slice of a Text; substring shares the buffer.
  */
 struct String : ValueBase {
-    std::string s;
+    std::shared_ptr<Text> text;
+    size_t offset, length;
     String(const std::string &);
+    String(const std::shared_ptr<Text> &, size_t, size_t);
+    std::string str() const;
+    char at(size_t) const;
     virtual void show(std::ostream &) override;
 };
 Value StringV(const std::string &);
+Value SubstringV(const String &, size_t, size_t);
+Value StringAppendV(const String &, const String &);
 
 // ============================================================================
 // Special Value Types
@@ -173,20 +383,239 @@ struct Pair : ValueBase {
     Pair(const Value &, const Value &);
     virtual void show(std::ostream &) override;
     virtual void showCdr(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
 };
 Value PairV(const Value &, const Value &);
 
+/**
+ * @brief Arity dispatch of a case-lambda
+ * by_arity[n] is the clause taking n arguments; larger counts go to tail,
+ * the first clause with a rest parameter.
+ */
+struct CaseTable {
+    std::vector<Value> by_arity;
+    Value tail;
+    CaseTable() : tail(nullptr) {}
+};
+
 /**
  * @brief Procedure (function) value
  */
 struct Procedure : ValueBase {
     std::vector<std::string> parameters;   ///< Parameter names
+    std::string rest;                      ///< Rest parameter, empty if none
+    bool rest_used;                        ///< Whether the body refers to rest
     Expr e;                                ///< Function body expression
     Assoc env;                             ///< Closure environment
+    std::shared_ptr<CaseTable> cases;      ///< Clauses of a case-lambda
     Procedure(const std::vector<std::string> &, const Expr &, const Assoc &);
+    Procedure(const std::vector<std::string> &, const std::string &, bool, const Expr &, const Assoc &);
     virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
 };
 Value ProcedureV(const std::vector<std::string> &, const Expr &, const Assoc &);
+Value ProcedureV(const std::vector<std::string> &, const std::string &, bool, const Expr &, const Assoc &);
+Value CaseProcedureV(const std::shared_ptr<CaseTable> &, const Assoc &);
+Value applyProcedure(const Value &, const std::vector<Value> &);
+
+/**
+ * @brief Escape continuation captured by call/cc
+ *
+ * Capturing is O(1): nothing is copied, the call/cc frame itself is the
+ * continuation. Invoking it unwinds the C++ stack back to that frame, which
+ * is only possible while the frame is still live.
+ */
+struct ContinuationState {
+    bool active;
+    ContinuationState();
+};
+
+/**
+ * @brief Thrown to carry a value back to the call/cc that made the target
+ */
+struct ContinuationThrow {
+    std::shared_ptr<ContinuationState> target;
+    Value v;
+    ContinuationThrow(const std::shared_ptr<ContinuationState> &, const Value &);
+};
+
+/**
+ * @brief Shared state of a promise
+ *
+ * delay-force chains hand their box on to the promise they produce, so a
+ * chain of any length is forced in a loop and memoized in one place.
+ */
+struct PromiseBox {
+    bool done;      ///< value holds the result
+    bool lazy;      ///< e yields another promise (delay-force)
+    Value value;
+    Expr e;
+    Assoc env;
+    PromiseBox(bool, const Value &, const Expr &, const Assoc &);
+};
+
+/**
+ * @brief Promise created by delay, delay-force or make-promise
+ */
+struct Promise : ValueBase {
+    std::shared_ptr<PromiseBox> box;
+    Promise(const std::shared_ptr<PromiseBox> &);
+    virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
+};
+Value PromiseV(const Expr &, const Assoc &, bool);
+Value ReadyPromiseV(const Value &);
+Value force(const Value &);
+
+/**
+ * @brief Record type descriptor created by define-record-type
+ */
+struct RecordType {
+    std::string name;
+    std::vector<std::string> fields;
+    RecordType(const std::string &, const std::vector<std::string> &);
+};
+
+/**
+ * @brief Record instance, one slot per field of its type
+ */
+struct Record : ValueBase {
+    std::shared_ptr<RecordType> type;
+    std::vector<Value> slots;
+    Record(const std::shared_ptr<RecordType> &);
+    virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
+};
+Value RecordV(const std::shared_ptr<RecordType> &);
+
+/**
+ * @brief Hashing and comparison of keys that agree with eq?
+ * Fixnums go by value and everything else by address. Values never move,
+ * so an address hashes the same for the whole life of its value.
+ */
+struct EqHash {
+    size_t operator()(const ValueBase *) const;
+};
+struct EqEqual {
+    bool operator()(const ValueBase *, const ValueBase *) const;
+};
+
+/**
+ * @brief Hashtable made by make-eq-hashtable or make-weak-eq-hashtable
+ *
+ * A weak table holds its keys without counting them, and an entry goes
+ * when its key dies. Values are held as usual, so a value referring to its
+ * own key keeps the entry. Fixnum keys, equal under eq? whenever their
+ * values are, are always held.
+ */
+struct Hashtable : ValueBase {
+    struct Entry {
+        Value key;      ///< Unset when the table holds the key weakly
+        Value value;
+        Entry() : key(nullptr), value(nullptr) {}
+    };
+    bool weak;
+    std::unordered_map<const ValueBase *, Entry, EqHash, EqEqual> entries;
+    Hashtable(bool);
+    ~Hashtable();
+    Value ref(const Value &) const;      ///< Null pointer when missing
+    void set(const Value &, const Value &);
+    bool remove(const Value &);
+    void clear();
+    size_t size() const;
+    std::vector<Value> keys() const;
+    virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
+};
+Value HashtableV(bool);
+
+/**
+ * @brief Output port
+ * A string port appends to its own growable buffer; the console port
+ * writes to std::cout.
+ */
+struct Port : ValueBase {
+    std::ostream *os;
+    std::shared_ptr<std::ostringstream> buffer;   ///< Set on string ports only
+    Port(std::ostream *);
+    Port();
+    virtual void show(std::ostream &) override;
+};
+Value OutputStringPortV();
+Value ConsolePortV();
+
+/**
+ * @brief End-of-file object returned by the input procedures
+ */
+struct EofValue : ValueBase {
+    EofValue();
+    virtual void show(std::ostream &) override;
+};
+Value EofV();
+
+/**
+ * @brief Future made by (future thunk), running on the thread pool
+ */
+struct Future : ValueBase {
+    std::shared_ptr<Task> task;
+    Future(const std::shared_ptr<Task> &);
+    virtual void show(std::ostream &) override;
+};
+Value FutureV(const std::shared_ptr<Task> &);
+
+/**
+ * @brief Marker returned by (values ...) with other than one value
+ *
+ * The values themselves sit in a register that the receiving
+ * call-with-values or let-values reads straight away, so returning several
+ * values allocates nothing. A single value is returned as itself.
+ */
+struct MultipleValues : ValueBase {
+    MultipleValues();
+    virtual void show(std::ostream &) override;
+};
+Value ValuesV(const std::vector<Value> &);
+void takeValues(const Value &, std::vector<Value> &);
+
+/**
+ * @brief The value itself; a RuntimeError if it is the marker for several
+ * Anything that keeps or passes a value on checks with this, since the
+ * marker only means something until the next values call overwrites it.
+ */
+[[noreturn]] void multipleValuesError();
+inline const Value &oneValue(const Value &v) {
+    if (v->v_type == V_VALUES) {
+        multipleValuesError();
+    }
+    return v;
+}
+
+/**
+ * @brief Error object made by error, or by a guard catching a RuntimeError
+ */
+struct ErrorObject : ValueBase {
+    std::string message;
+    Value irritants;
+    ErrorObject(const std::string &, const Value &);
+    virtual void show(std::ostream &) override;
+    virtual void traverse(GcVisitor &) override;
+    virtual void clearRefs() override;
+};
+Value ErrorObjectV(const std::string &, const Value &);
+
+/**
+ * @brief Thrown by raise when no handler takes the object before a guard
+ * or the top level
+ */
+struct SchemeRaise {
+    Value payload;
+    SchemeRaise(const Value &);
+};
 
 // ============================================================================
 // Utility Functions